@@ -0,0 +1,16 @@
+uint hash(uint state)
+{
+	state ^= 2747636419u;
+	state *= 2654435769u;
+	state ^= state >> 16;
+	state *= 2654435769u;
+	state ^= state >> 16;
+	state *= 2654435769u;
+	return state;
+}
+
+float uintToRange01(uint state)
+{
+	float res = state / 4294967295.f;
+	return res;
+}
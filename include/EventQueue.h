@@ -0,0 +1,118 @@
+#pragma once
+
+#include "event.h"
+
+#include <atomic>
+
+namespace Atlas {
+
+	// bounded ring any thread can push to, drained by a single consumer
+	// every slot carries a sequence number telling producers and the consumer whose turn it is
+	class EventQueue {
+	public:
+		EventQueue(uint32_t capacity = 1024)
+		{
+			uint32_t size = 1;
+			while (size < capacity) size <<= 1;
+
+			m_Mask = size - 1;
+			m_Slots = std::make_unique<Slot[]>(size);
+			for (uint32_t i = 0; i < size; i++) m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		EventQueue(const EventQueue &) = delete;
+		EventQueue &operator=(const EventQueue &) = delete;
+
+		// false when the ring is full, the event is not queued then
+		bool push(const Event &event)
+		{
+			uint64_t pos = m_Tail.load(std::memory_order_relaxed);
+
+			while (true) {
+				Slot &slot = m_Slots[pos & m_Mask];
+				uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+				int64_t diff = (int64_t)sequence - (int64_t)pos;
+
+				if (diff == 0) {
+					if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						slot.event = event;
+						slot.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0) {
+					return false;
+				}
+				else {
+					pos = m_Tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// consumer only
+		bool pop(Event &event)
+		{
+			Slot &slot = m_Slots[m_Head & m_Mask];
+			if (slot.sequence.load(std::memory_order_acquire) != m_Head + 1) return false;
+
+			event = slot.event;
+			slot.sequence.store(m_Head + m_Mask + 1, std::memory_order_release);
+			m_Head++;
+			return true;
+		}
+
+		// consumer only, passes at most one ring worth of events to func in the order they were pushed,
+		// a run of mouse moves collapses into the last position and a run of scrolls into one with the summed offsets
+		template<typename F>
+		uint32_t drain(F &&func)
+		{
+			uint32_t popped = 0;
+			bool hasPending = false;
+			Event pending{ WindowClosedEvent{} };
+			Event event{ WindowClosedEvent{} };
+
+			while (popped <= m_Mask && pop(event)) {
+				popped++;
+
+				if (hasPending) {
+					EventType type = event.get_type();
+					EventType pendingType = pending.get_type();
+
+					if (type == EventType::MouseMoved && pendingType == EventType::MouseMoved) {
+						pending = event;
+						continue;
+					}
+					if (type == EventType::MouseScrolled && pendingType == EventType::MouseScrolled) {
+						auto &scroll = pending.get<MouseScrolledEvent>();
+						scroll.offsetX += event.get<MouseScrolledEvent>().offsetX;
+						scroll.offsetY += event.get<MouseScrolledEvent>().offsetY;
+						continue;
+					}
+
+					func(pending);
+				}
+
+				pending = event;
+				hasPending = true;
+			}
+
+			if (hasPending) func(pending);
+			return popped;
+		}
+
+		inline uint32_t capacity() const { return (uint32_t)m_Mask + 1; }
+
+	private:
+		struct Slot {
+			std::atomic<uint64_t> sequence{ 0 };
+			Event event{ WindowClosedEvent{} };
+		};
+
+		std::unique_ptr<Slot[]> m_Slots;
+		uint64_t m_Mask{ 0 };
+
+		// producers and the consumer on separate cache lines
+		alignas(64) std::atomic<uint64_t> m_Tail{ 0 };
+		alignas(64) uint64_t m_Head{ 0 };
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "event.h"
+
+#include <bitset>
+#include <glm/glm.hpp>
+
+namespace Atlas {
+
+	// keyboard and mouse state of one frame, built from the events that arrived before it
+	struct InputSnapshot {
+		uint64_t frame = 0;
+
+		std::bitset<512> keys;
+		// keys that went down or up since the previous snapshot, a tap within one frame shows up in both
+		std::bitset<512> keysPressed;
+		std::bitset<512> keysReleased;
+
+		uint8_t mouseButtons = 0;
+		uint8_t mousePressed = 0;
+		uint8_t mouseReleased = 0;
+
+		glm::vec2 mouse{ 0.0f };
+		bool viewportFocused = false;
+		bool viewportHovered = false;
+
+		// for queries that combine several fields, they all come from the same frame
+		inline bool is_key_down(KeyCode key) const { return (int)key >= 0 && (int)key < (int)keys.size() && keys.test((int)key); }
+		inline bool is_mouse_down(int button) const { return button >= 0 && button < 8 && (mouseButtons >> button) & 1; }
+	};
+
+	// the Application feeds events and publishes a snapshot at the start of every frame,
+	// reads go to the published snapshot and are safe from jobs of the current and the previous frame
+	namespace Input {
+
+		void on_event(const Event &event);
+		// overrides the tracked state, used when the state comes from a replay instead of events
+		void set_state(const std::bitset<512> &keys, uint8_t mouseButtons);
+		void new_frame(uint64_t frame, const glm::vec2 &mouse, bool viewportFocused, bool viewportHovered);
+
+		const InputSnapshot &get_snapshot();
+
+		bool is_key_down(KeyCode key);
+		bool was_key_pressed(KeyCode key);
+		bool was_key_released(KeyCode key);
+
+		bool is_mouse_down(int button);
+		bool was_mouse_pressed(int button);
+		bool was_mouse_released(int button);
+
+		glm::vec2 get_mouse();
+	}
+}
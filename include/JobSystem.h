@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+namespace Atlas::Jobs {
+
+	struct Job;
+
+	// number of unfinished jobs submitted against it, jobs queued with run_after start once it dropped to zero
+	class Counter {
+	public:
+		Counter() = default;
+		Counter(const Counter &) = delete;
+		Counter &operator=(const Counter &) = delete;
+
+		inline bool is_done() const { return m_Value.load(std::memory_order_acquire) == 0; }
+		inline uint32_t get() const { return m_Value.load(std::memory_order_acquire); }
+
+	private:
+		friend void add(Counter *counter, uint32_t count);
+		friend void finish(Counter *counter);
+		friend void run_after(Counter &dependency, std::function<void()> func, Counter *counter);
+		friend void wait(Counter &counter);
+
+		std::atomic<uint32_t> m_Value{ 0 };
+		std::mutex m_Mutex;
+		std::vector<Job> m_Continuations;
+	};
+
+	// a chunk of a parallel_for runs through range, everything else through func
+	struct Job {
+		std::function<void()> func;
+		void (*range)(const void *data, size_t begin, size_t end) = nullptr;
+		const void *data = nullptr;
+		size_t begin = 0;
+		size_t end = 0;
+
+		Counter *counter = nullptr;
+	};
+
+	// workers besides the main thread, 0 uses one per hardware thread minus the main thread
+	void init(uint32_t workers = 0);
+	void shutdown();
+	bool is_initialized();
+
+	// threads running jobs, including the main thread that helps while it waits
+	uint32_t get_thread_count();
+	bool is_main_thread();
+	// 0 on the main thread, 1 to get_thread_count() - 1 on workers, -1 on threads the job system doesn't know
+	int get_worker_index();
+
+	void add(Counter *counter, uint32_t count);
+	void finish(Counter *counter);
+
+	// the job's counter has to account for it already, see add
+	void submit(Job job);
+
+	// runs on any worker, counter is incremented now and decremented once func returned
+	void run(std::function<void()> func, Counter *counter = nullptr);
+	void run_after(Counter &dependency, std::function<void()> func, Counter *counter = nullptr);
+
+	// for work that needs the GL context, runs on the main thread in wait or at the start of the next frame
+	void run_on_main(std::function<void()> func, Counter *counter = nullptr);
+	void execute_main_jobs();
+
+	// runs queued jobs on the calling thread until counter is done, main jobs too when called from the main thread,
+	// a counter may only be destroyed after a wait on it returned
+	void wait(Counter &counter);
+
+	// calls func(begin, end) on chunks of about grain elements across all threads and returns once every chunk ran,
+	// a grain of 0 splits the range into a few chunks per thread
+	template<typename F>
+	void parallel_for_range(size_t begin, size_t end, size_t grain, F &&func)
+	{
+		if (begin >= end) return;
+
+		size_t count = end - begin;
+		if (grain == 0) grain = std::max<size_t>(1, count / (get_thread_count() * 4));
+
+		if (count <= grain || get_thread_count() == 1) {
+			func(begin, end);
+			return;
+		}
+
+		using T = std::remove_reference_t<F>;
+
+		Counter counter;
+		Job job{};
+		job.range = [](const void *data, size_t chunkBegin, size_t chunkEnd) { (*(T *)data)(chunkBegin, chunkEnd); };
+		job.data = (const void *)&func;
+		job.counter = &counter;
+
+		size_t chunks = (count + grain - 1) / grain;
+		add(&counter, (uint32_t)chunks);
+
+		// the first chunk runs here, the rest is up for stealing
+		for (size_t chunk = 1; chunk < chunks; chunk++) {
+			job.begin = begin + chunk * grain;
+			job.end = std::min(end, job.begin + grain);
+			submit(job);
+		}
+
+		func(begin, std::min(end, begin + grain));
+		finish(&counter);
+		wait(counter);
+	}
+
+	// calls func(i) for every i in [begin, end)
+	template<typename F>
+	void parallel_for(size_t begin, size_t end, F &&func, size_t grain = 0)
+	{
+		parallel_for_range(begin, end, grain, [&func](size_t chunkBegin, size_t chunkEnd) {
+			for (size_t i = chunkBegin; i < chunkEnd; i++) func(i);
+		});
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "atl_types.h"
+
+namespace Atlas::Profiler {
+
+	struct GpuScopeResult {
+		const char *name;
+		uint32_t depth;
+		float startMs;	// relative to the start of the frame
+		float durationMs;
+	};
+
+	// GL_ARB_pipeline_statistics_query counters of a whole frame
+	struct GpuPipelineStatistics {
+		uint64_t verticesSubmitted = 0;
+		uint64_t primitivesSubmitted = 0;
+		uint64_t vertexShaderInvocations = 0;
+		uint64_t clippingInputPrimitives = 0;
+		uint64_t fragmentShaderInvocations = 0;
+		uint64_t computeShaderInvocations = 0;
+	};
+
+	struct GpuFrameResult {
+		uint64_t frameIndex = 0;
+		float gpuMs = 0;
+		std::vector<GpuScopeResult> scopes;
+
+		bool hasStatistics = false;
+		GpuPipelineStatistics statistics;
+	};
+
+	// called by the Render api, results of a frame are resolved once it retired
+	void init();
+	void frame_start();
+	void frame_end();
+
+	// name has to outlive the frame, ATL_GPU_EVENT only passes string literals
+	void gpu_begin(const char *name);
+	void gpu_end();
+
+	void enable_gpu_timing(bool enable);
+	bool is_gpu_timing_enabled();
+
+	void enable_pipeline_statistics(bool enable);
+	bool has_pipeline_statistics();
+
+	// newest frame with resolved results, a few frames behind the one being recorded
+	const GpuFrameResult &get_gpu_frame();
+
+	void show_gpu_timeline();
+
+	struct FrameRecord {
+		uint64_t frameIndex = 0;
+		float cpuMs = 0;
+		float gpuMs = -1;		// negative until the GPU results of the frame resolved
+		float presentMs = 0;	// event polling and swap that preceded the frame
+		bool overBudget = false;	// cpu or gpu time, present blocks on vsync and is only reported
+	};
+
+	struct Percentiles {
+		float p50 = 0;
+		float p95 = 0;
+		float p99 = 0;
+		float max = 0;
+	};
+
+	// over the frames still held by the ring, at most FRAME_RING_SIZE
+	struct FrameStatistics {
+		uint32_t frameCount = 0;
+		Percentiles cpu;
+		Percentiles gpu;
+		Percentiles present;
+		uint32_t overBudget = 0;
+	};
+
+	struct ScopeTime {
+		const char *name;
+		uint32_t depth;
+		float ms;
+	};
+
+	// a frame over budget and the longest CPU and GPU scopes it spent its time in
+	struct Hitch {
+		uint64_t frameIndex = 0;
+		float cpuMs = 0;
+		float gpuMs = -1;
+		float presentMs = 0;
+		std::vector<ScopeTime> cpuScopes;
+		std::vector<GpuScopeResult> gpuScopes;
+	};
+
+	constexpr uint32_t FRAME_RING_SIZE = 1024;
+
+	// called by the Application once per frame, from the main thread
+	void record_frame(uint64_t frameIndex, float cpuMs, float presentMs);
+
+	void set_frame_budget(float ms);
+	float get_frame_budget();
+
+	// safe to call from any thread, the ring is written without locks
+	FrameStatistics get_frame_statistics();
+	std::vector<FrameRecord> get_frame_records();
+
+	const std::deque<Hitch> &get_hitches();
+
+	// keeps every frame instead of the ring only so the whole run can be written out
+	void keep_frame_history(bool keep);
+	bool write_frame_csv(const std::string &path);
+
+	void show_frame_statistics();
+
+	class GpuScope {
+	public:
+		GpuScope(const char *name) { gpu_begin(name); }
+		~GpuScope() { gpu_end(); }
+
+		GpuScope(const GpuScope &) = delete;
+		GpuScope &operator=(const GpuScope &) = delete;
+	};
+}
+
+// times the enclosed GL commands on the GPU and opens a CPU event of the same name, block scope only like ATL_EVENT
+#define ATL_GPU_EVENT(NAME) ATL_EVENT(NAME); ::Atlas::Profiler::GpuScope ATL_CONCAT(atlGpuScope, __LINE__)(NAME)
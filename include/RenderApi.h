@@ -19,6 +19,20 @@ namespace Atlas {
 		void frame_start();
 		void frame_end();
 
+		// frames the CPU may record ahead of the GPU (1-3), frame_start blocks on the oldest one beyond that
+		void set_frames_in_flight(uint32_t count);
+		uint32_t get_frames_in_flight();
+
+		// index of the frame being recorded and of the last frame the GPU finished
+		uint64_t get_frame_index();
+		uint64_t get_retired_frame();
+
+		// runs once the GPU finished the frame currently being recorded
+		void on_frame_retired(std::function<void()> func);
+
+		// blocks until every submitted frame retired and ran its callbacks
+		void wait_idle();
+
 		void enable_clear_color(bool b);
 		void enable_clear_depth(bool b);
 		void clear_color(Atlas::RGBA c);
@@ -34,5 +48,11 @@ namespace Atlas {
 
 		void init();
 		void resize_viewport(uint32_t width, uint32_t height);
+
+		// directory for cached program binaries, an empty path disables the cache
+		void set_shader_cache_dir(const std::string &directory);
+
+		// directory with the SPIR-V modules built by the shaders target, an empty path always compiles GLSL
+		void set_spirv_dir(const std::string &directory);
 	}
 }
\ No newline at end of file
@@ -3,9 +3,15 @@
 #include "atl_types.h"
 
 #include "camera.h"
+#include "JobSystem.h"
+#include "Input.h"
 
 namespace Atlas {
 	class Window;
+	class EventRecorder;
+	class EventReplayer;
+	class EventQueue;
+	struct RecordedInput;
 
 	class ImGuiLayer;
 
@@ -32,6 +38,8 @@ namespace Atlas {
 		virtual void on_attach() {}
 		virtual void on_detach() {}
 		virtual void on_update(Timestep ts) {}
+		// runs at the fixed timestep of the Application, zero or more times per frame before on_update
+		virtual void on_fixed_update(Timestep ts) {}
 		virtual void on_imgui() {}
 		virtual void on_event(Event &event) {}
 	};
@@ -40,6 +48,26 @@ namespace Atlas {
 		std::string title;
 		uint32_t width;
 		uint32_t height;
+
+		// frame statistics of the whole run are written here as csv on exit
+		std::string frameStatsPath;
+
+		// no window, ImGui or swap, layers render into a fixed width x height viewport texture
+		bool headless{ false };
+		// frames run() renders before returning, 0 runs until the window closes or close() is called
+		uint32_t frameCount{ 0 };
+
+		// window events, timesteps and input state are logged here
+		std::string recordPath;
+		// plays a log back at the same frames instead of listening to the window, closes when it ran out
+		std::string replayPath;
+
+		// tick of on_fixed_update, a frame runs at most maxFixedSteps of them and drops the rest
+		float fixedTimestep{ 1.0f / 60.0f };
+		uint32_t maxFixedSteps{ 8 };
+
+		// worker threads of the job system besides the main thread, 0 uses one per hardware thread
+		uint32_t jobWorkers{ 0 };
 	};
 
 	class Application {
@@ -57,8 +85,14 @@ namespace Atlas {
 		~Application();
 
 		void run();
+		// runs frames until done returns true, checked after every frame
+		void run_until(const std::function<bool()> &done);
 		void update();
 
+		static void close();
+		static bool is_headless();
+		static uint64_t get_frames_run();
+
 		static void update_frame();
 
 		static Window &get_window();
@@ -72,38 +106,71 @@ namespace Atlas {
 		static float get_time();
 		static Texture2D &get_viewport_color();
 		static void set_vsync(bool enable);
+
+		static void set_fixed_timestep(float seconds);
+		static float get_fixed_timestep();
+		static void set_max_fixed_steps(uint32_t steps);
+		// how far the frame is between the last fixed step and the next, for interpolating sim state
+		static float get_fixed_alpha();
+		static uint32_t get_fixed_steps();
+		static uint64_t get_dropped_fixed_steps();
 		//static Texture2D &get_viewport_depth();
 
 		void push_layer(Ref<Layer> layer);
 
+		// safe from any thread, dispatched at the start of the next frame
 		void queue_event(Event event);
 
 		static glm::vec2 &get_viewport_size();
 
 	private:
+		void on_window_event(Event &event);
+		void process_window_events();
+		void handle_window_event(Event &event);
 		void on_event(Event &event);
 		bool on_window_resized(WindowResizedEvent &e);
 		bool on_viewport_resized(ViewportResizedEvent &e);
 		bool on_mouse_moved(MouseMovedEvent &e);
 
 		void render_viewport();
+		void run_fixed_steps(Timestep timestep);
 
 		Scope<Window> m_Window;
 		bool m_WindowMinimized = false;
 
 		float m_LastFrameTime{ 0 };
 
+		std::string m_FrameStatsPath;
+
+		bool m_Headless{ false };
+		uint32_t m_FrameCount{ 0 };
+		uint64_t m_FramesRun{ 0 };
+
+		float m_FixedTimestep{ 1.0f / 60.0f };
+		uint32_t m_MaxFixedSteps{ 8 };
+		float m_FixedAccumulator{ 0 };
+		float m_FixedAlpha{ 0 };
+		uint32_t m_FixedSteps{ 0 };
+		uint64_t m_DroppedFixedSteps{ 0 };
+
+		Scope<EventRecorder> m_Recorder;
+		Scope<EventReplayer> m_Replayer;
+		// the input snapshot and viewport state written to the log every frame
+		Scope<RecordedInput> m_Input;
+
 		Ref<ImGuiLayer> m_ImGuiLayer;
 		std::vector<Ref<Layer>> m_LayerStack;
 
-		std::vector<Event> m_QueuedEvents;
+		// window callbacks only queue, both are drained once per frame with mouse moves and scrolls coalesced
+		Scope<EventQueue> m_WindowEvents;
+		Scope<EventQueue> m_QueuedEvents;
 
 		Texture2D m_ColorBuffer;
 		//Texture2D m_DepthBuffer;
 
 		glm::vec2 m_ViewportSize;
-		bool m_ViewportFocus;
-		bool m_ViewportHovered;
+		bool m_ViewportFocus{ false };
+		bool m_ViewportHovered{ false };
 		glm::vec2 m_ViewportMousePos;
 
 		std::thread m_RenderThread;
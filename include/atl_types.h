@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/type_trait.hpp>
 
+#include "JobSystem.h"
+
 namespace gl_utils {
 	class GLTexture2D;
 	class GLFramebuffer;
@@ -12,6 +14,7 @@ namespace gl_utils {
 	class GLShader;
 	class GLVertexLayout;
 	class GLShader;
+	class GLFence;
 }
 
 namespace Atlas {
@@ -39,7 +42,208 @@ namespace ImGui {
 namespace Atlas {
 
 	namespace Random {
+
+		// xoshiro256++, seeded through splitmix64 so nearby seeds still give unrelated sequences
+		class Generator {
+		public:
+			Generator(uint64_t seed = 0) { reseed(seed); }
+
+			// the sequence of seed advanced by index * 2^128 draws, streams of one seed never overlap.
+			// costs index jumps, meant for small indices like the worker index
+			static Generator stream(uint64_t seed, uint64_t index)
+			{
+				Generator generator(seed);
+				for (uint64_t i = 0; i < index; i++) generator.jump();
+				return generator;
+			}
+
+			// advances the state by 2^128 draws
+			void jump()
+			{
+				static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+
+				uint64_t state[4] = { 0, 0, 0, 0 };
+				for (uint64_t word : JUMP) {
+					for (int bit = 0; bit < 64; bit++) {
+						if (word & (1ull << bit)) {
+							for (int i = 0; i < 4; i++) state[i] ^= m_State[i];
+						}
+						next();
+					}
+				}
+				for (int i = 0; i < 4; i++) m_State[i] = state[i];
+			}
+
+			void reseed(uint64_t seed)
+			{
+				for (auto &state : m_State) state = splitmix64(seed);
+			}
+
+			inline uint64_t next()
+			{
+				const uint64_t result = rotl(m_State[0] + m_State[3], 23) + m_State[0];
+				const uint64_t t = m_State[1] << 17;
+
+				m_State[2] ^= m_State[0];
+				m_State[3] ^= m_State[1];
+				m_State[1] ^= m_State[2];
+				m_State[0] ^= m_State[3];
+				m_State[2] ^= t;
+				m_State[3] = rotl(m_State[3], 45);
+
+				return result;
+			}
+
+			// [min, max] without modulo bias, Lemire's multiply and reject up to 32 bit ranges, masked rejection above
+			template<typename T>
+			std::enable_if_t<std::is_integral_v<T>, T> range(T min, T max)
+			{
+				using U = std::make_unsigned_t<T>;
+				uint64_t span = (uint64_t)(U)((U)max - (U)min) + 1;
+				if (span == 0) return (T)next();
+
+				uint64_t offset = 0;
+				if (span <= 0xFFFFFFFFull) {
+					uint64_t m = (next() >> 32) * span;
+					if ((uint32_t)m < span) {
+						uint32_t threshold = (uint32_t)(0x100000000ull % span);
+						while ((uint32_t)m < threshold) m = (next() >> 32) * span;
+					}
+					offset = m >> 32;
+				}
+				else {
+					uint64_t mask = ~0ull >> count_leading_zeros(span - 1);
+					do offset = next() & mask; while (offset >= span);
+				}
+
+				return (T)(U)((U)min + (U)offset);
+			}
+
+			// [min, max)
+			template<typename T>
+			std::enable_if_t<std::is_floating_point_v<T>, T> range(T min, T max)
+			{
+				return min + (max - min) * (T)unit();
+			}
+
+			// [0, 1) from the top 53 bits
+			inline double unit()
+			{
+				return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+			}
+
+		private:
+			static inline uint64_t rotl(uint64_t x, int k)
+			{
+				return (x << k) | (x >> (64 - k));
+			}
+
+			static inline uint64_t splitmix64(uint64_t &x)
+			{
+				uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				return z ^ (z >> 31);
+			}
+
+			static inline int count_leading_zeros(uint64_t x)
+			{
+				int n = 0;
+				while (!(x & (1ull << 63))) { x <<= 1; n++; }
+				return n;
+			}
+
+			uint64_t m_State[4];
+		};
+
 		void init();
+		// same seed, same sequence on the calling thread, event replays rely on it
+		void init(uint64_t seed);
+		uint64_t get_seed();
+
+		// the calling thread's generator. the job system's threads draw from the stream of the seed given by their
+		// worker index, so a run with the same seed and worker count repeats, threads outside of it get the streams after
+		Generator &get_generator();
+
+		// calls func(generator, data, count) on chunks of out spread over the job system, each chunk draws from its own
+		// stream so the result only depends on the calling thread's generator and the size, not on how many threads ran it
+		template<typename T, typename F>
+		void generate_chunks(Span<T> out, F &&func)
+		{
+			const size_t minChunk = 1 << 16;
+			const size_t maxStreams = 64;
+
+			size_t streamCount = std::clamp<size_t>((out.size() + minChunk - 1) / minChunk, 1, maxStreams);
+			size_t chunk = (out.size() + streamCount - 1) / streamCount;
+
+			// consecutive jumps of one generator, cheaper than a Generator::stream per chunk
+			std::array<Generator, maxStreams> streams;
+			streams[0] = Generator(get_generator().next());
+			for (size_t i = 1; i < streamCount; i++) {
+				streams[i] = streams[i - 1];
+				streams[i].jump();
+			}
+
+			Jobs::parallel_for(0, streamCount, [&](size_t stream) {
+				size_t begin = stream * chunk;
+				size_t end = std::min(out.size(), begin + chunk);
+				if (begin < end) func(streams[stream], out.data() + begin, end - begin);
+			}, 1);
+		}
+
+		// writes func(generator) to every element
+		template<typename T, typename F>
+		void generate(Span<T> out, F &&func)
+		{
+			generate_chunks(out, [&func](Generator &generator, T *data, size_t count) {
+				for (size_t i = 0; i < count; i++) data[i] = func(generator);
+			});
+		}
+
+		// every element uniform in [min, max], power of two integer ranges take several values out of each draw
+		template<typename T>
+		void fill(Span<T> out, T min, T max)
+		{
+			if constexpr (std::is_integral_v<T>) {
+				using U = std::make_unsigned_t<T>;
+				uint64_t span = (uint64_t)(U)((U)max - (U)min) + 1;
+
+				if (span > 1 && span <= 0x100000000ull && (span & (span - 1)) == 0) {
+					uint32_t bits = 0;
+					while ((1ull << bits) < span) bits++;
+
+					// the whole range of the type is just random bytes
+					if (bits == sizeof(T) * 8) {
+						generate_chunks(out, [](Generator &generator, T *data, size_t count) {
+							uint8_t *bytes = (uint8_t *)data;
+							size_t size = count * sizeof(T);
+							for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+								uint64_t word = generator.next();
+								std::memcpy(bytes + i, &word, std::min(sizeof(uint64_t), size - i));
+							}
+						});
+						return;
+					}
+
+					generate_chunks(out, [min, span, bits](Generator &generator, T *data, size_t count) {
+						uint64_t word = 0;
+						uint32_t bitsLeft = 0;
+						for (size_t i = 0; i < count; i++) {
+							if (bitsLeft < bits) {
+								word = generator.next();
+								bitsLeft = 64;
+							}
+							data[i] = (T)(U)((U)min + (U)(word & (span - 1)));
+							word >>= bits;
+							bitsLeft -= bits;
+						}
+					});
+					return;
+				}
+			}
+
+			generate(out, [min, max](Generator &generator) { return generator.range(min, max); });
+		}
 
 		template<typename T>
 		struct is_randomizable {
@@ -81,13 +285,12 @@ namespace Atlas {
 
 		template<typename T>
 		std::enable_if_t<std::is_integral_v<T>, T> get(T min, T max) {
-			T range = max - min + 1;
-			return min + (get<T>() % range + range) % range;
+			return get_generator().range(min, max);
 		}
 
 		template<typename T>
 		std::enable_if_t<std::is_floating_point_v<T>, T> get(T min, T max) {
-			return get<T>() * (max - min) + min;
+			return get_generator().range(min, max);
 		}
 
 		template<typename T>
@@ -207,6 +410,17 @@ namespace Atlas {
 		bool mipmap;
 	};
 
+	// receives the data of a read_async call once the frame it was issued in retired,
+	// the pointer is only valid during the callback
+	using ReadbackCallback = std::function<void(const void *data, size_t size)>;
+
+	struct TextureRegion {
+		uint32_t x{ 0 };
+		uint32_t y{ 0 };
+		uint32_t width{ 0 };	// 0 reads to the edge of the texture
+		uint32_t height{ 0 };
+	};
+
 	namespace TextureUsage {
 		enum _ : uint32_t {
 			SAMPLER = 1 << 0,
@@ -216,6 +430,25 @@ namespace Atlas {
 	}
 	using TextureUsageBits = uint32_t;
 
+	// written by an engine compute kernel straight into the texture, nothing is staged on the host
+	enum class TexturePattern : uint32_t {
+		RANDOM,			// every channel drawn on its own
+		RANDOM_GRAY,	// one value for all channels
+		GRADIENT_X,
+		GRADIENT_Y,
+		CHECKER,
+	};
+
+	struct TexturePatternInfo {
+		TexturePattern pattern{ TexturePattern::RANDOM };
+		// the pattern value in [0, 1] interpolates between these
+		RGBA from{ 0, 0, 0, 255 };
+		RGBA to{ 255, 255, 255, 255 };
+		// the same seed always gives the same contents, 0 draws one from Random
+		uint32_t seed{ 0 };
+		uint32_t cellSize{ 8 };
+	};
+
 	class Texture2D {
 	public:
 
@@ -236,10 +469,26 @@ namespace Atlas {
 
 		template <typename T>
 		void fill(T value) {
-			std::vector<T> data(width() * height(), value);
-			fill(data.data(), data.size() * sizeof(T));
+			if constexpr (std::is_same_v<T, RGBA>) {
+				clear(value);
+			}
+			else {
+				std::vector<T> data(width() * height(), value);
+				fill(data.data(), data.size() * sizeof(T));
+			}
 		}
 
+		// glClearTexImage, no upload
+		void clear(RGBA color) const;
+		// only R8G8B8A8 textures can be written by the kernel
+		void fill_pattern(const TexturePatternInfo &info) const;
+
+		// tightly packed rows, the callback runs a frame or two later
+		void read_async(const TextureRegion &region, ReadbackCallback callback) const;
+		void read_async(ReadbackCallback callback) const { read_async(TextureRegion{}, callback); }
+		// stalls until the GPU caught up, for tools and validation
+		std::vector<uint8_t> get_data() const;
+
 		uint32_t width() const;
 		uint32_t height() const;
 		bool has_mipmap() const;
@@ -313,6 +562,7 @@ namespace Atlas {
 	enum class BufferUsage : uint32_t {
 		STATIC,
 		DYNAMIC,
+		STREAM,	// rewritten every frame, orphaned by writes that start at offset 0
 	};
 
 
@@ -326,6 +576,50 @@ namespace Atlas {
 	}
 	using BufferTypeBits = uint32_t;
 
+	// any of these bits allocates immutable storage (glNamedBufferStorage)
+	namespace BufferStorage {
+		enum _ : uint32_t {
+			IMMUTABLE = 1 << 0,
+			MAP_READ = 1 << 1,
+			MAP_WRITE = 1 << 2,
+			PERSISTENT = 1 << 3,
+			COHERENT = 1 << 4,
+			DYNAMIC = 1 << 5,	// allows set_data
+		};
+	}
+	using BufferStorageBits = uint32_t;
+
+	namespace MapAccess {
+		enum _ : uint32_t {
+			READ = 1 << 0,
+			WRITE = 1 << 1,
+			INVALIDATE_RANGE = 1 << 2,
+			INVALIDATE_BUFFER = 1 << 3,
+			UNSYNCHRONIZED = 1 << 4,
+			FLUSH_EXPLICIT = 1 << 5,
+		};
+	}
+	using MapAccessBits = uint32_t;
+
+
+	// written by an engine compute kernel in 32 bit words, nothing is staged on the host
+	enum class BufferPattern : uint32_t {
+		RANDOM_UINT,
+		RANDOM_FLOAT,	// uniform in [min, max)
+		SEQUENCE,		// index of the word in the filled range
+	};
+
+	struct BufferPatternInfo {
+		BufferPattern pattern{ BufferPattern::RANDOM_UINT };
+		float min{ 0.0f };
+		float max{ 1.0f };
+		// the same seed always gives the same contents, 0 draws one from Random
+		uint32_t seed{ 0 };
+
+		// in bytes and multiples of 4, a size of 0 fills to the end of the buffer
+		size_t offset{ 0 };
+		size_t size{ 0 };
+	};
 
 	struct BufferCreateInfo {
 		size_t size;
@@ -334,6 +628,8 @@ namespace Atlas {
 
 		size_t stride;
 		void *data;
+
+		BufferStorageBits storage{ 0 };
 	};
 
 	class Buffer {
@@ -383,14 +679,36 @@ namespace Atlas {
 
 		static Buffer index(size_t count, BufferUsage usage = BufferUsage::STATIC);
 
+		static Buffer immutable(BufferTypeBits types, const void *data, size_t size, BufferStorageBits storage, size_t stride = 0);
+
+		// mapped PERSISTENT | COHERENT | MAP_WRITE, for streaming data without driver copies
+		template <typename T>
+		static Buffer persistent(BufferTypeBits types, size_t count) {
+			return immutable(types, nullptr, sizeof(T) * count, BufferStorage::PERSISTENT | BufferStorage::COHERENT | BufferStorage::MAP_WRITE, sizeof(T));
+		}
+
 		void set_data(void *data, size_t size);
+		void set_data(size_t offset, const void *data, size_t size);
+
+		template <typename T>
+		void set_data(size_t offset, Span<const T> data) {
+			set_data(offset, (const void *)data.data(), data.size_bytes());
+		}
 
 		template <typename T>
 		void set_data(const T &value) {
 			set_data((void *)&value, sizeof(T));
 		}
 
-		std::vector<void *> get_data();
+		// stalls until the GPU caught up, prefer read_async
+		std::vector<uint8_t> get_data() const;
+
+		// every 32 bit word of the range set to value with glClearNamedBufferSubData, a size of 0 clears to the end
+		void clear(uint32_t value, size_t offset = 0, size_t size = 0) const;
+		void fill_pattern(const BufferPatternInfo &info) const;
+
+		void read_async(size_t offset, size_t size, ReadbackCallback callback) const;
+		void read_async(ReadbackCallback callback) const { read_async(0, size(), callback); }
 
 		size_t size() const;
 		inline BufferTypeBits type() const { return m_Types; }
@@ -402,6 +720,18 @@ namespace Atlas {
 		static void unbind_index();
 		static void map_write(const Buffer &buffer, std::function<void(void *)> func);
 
+		// mapped once on first use and valid for the lifetime of the buffer, requires BufferStorage::PERSISTENT
+		template <typename T>
+		Span<T> map_persistent() const {
+			return Span<T>((T *)map_persistent_data(), size() / sizeof(T));
+		}
+
+		void *map_range(size_t offset, size_t size, MapAccessBits access) const;
+		void unmap() const;
+
+		// makes writes to a non coherent or FLUSH_EXPLICIT mapping visible to the GPU
+		void flush_range(size_t offset, size_t size) const;
+
 		friend bool operator==(const Buffer &b1, const Buffer &b2);
 		friend bool operator!=(const Buffer &b1, const Buffer &b2);
 
@@ -411,10 +741,31 @@ namespace Atlas {
 		Ref<gl_utils::GLBuffer> m_Buffer{ nullptr };
 		BufferTypeBits m_Types{ 0 };
 		size_t m_Stride{ 0 };
+		BufferUsage m_Usage{ BufferUsage::STATIC };
+		BufferStorageBits m_Storage{ 0 };
+
+		void *map_persistent_data() const;
 
 		friend class Shader;
 	};
 
+	class Fence {
+	public:
+
+		Fence() = default;
+
+		// signals once the GPU finished all commands submitted before it
+		static Fence insert();
+
+		bool is_signaled() const;
+		bool wait(uint64_t timeoutNs = UINT64_MAX) const;
+
+		inline bool is_init() const { return m_Fence != nullptr; }
+
+	private:
+		Ref<gl_utils::GLFence> m_Fence{ nullptr };
+	};
+
 	enum class VertexAttribute : uint32_t {
 		NONE,
 		INT, INT2, INT3, INT4,
@@ -537,9 +888,15 @@ namespace Atlas {
 		COMPUTE,
 	};
 
+	using ShaderDefines = std::map<std::string, std::string>;
+
 	struct ShaderCreateInfo {
 		std::vector<std::pair<std::string, ShaderType>> modules;
 		VertexLayout layout;
+		ShaderDefines defines;
+
+		// compile in the background, the first use of the shader waits for completion
+		bool async{ false };
 	};
 
 	class Shader {
@@ -552,10 +909,11 @@ namespace Atlas {
 		static void unbind();
 		static void dispatch(const Shader &shader, uint32_t nGroupsX, uint32_t nGroupsY, uint32_t nGroupsZ);
 
-		static Shader load_vert_frag(const std::string &vertexFile, const std::string &fragFile, const VertexLayout &layout);
-		static Shader load_comp(const std::string &file);
+		static Shader load_vert_frag(const std::string &vertexFile, const std::string &fragFile, const VertexLayout &layout, bool async = false);
+		static Shader load_comp(const std::string &file, bool async = false);
 
 		inline bool is_init() const { return m_Shader != nullptr; }
+		bool is_ready() const;
 
 		void set_int(const std::string &name, int32_t value);
 		void set_int2(const std::string &name, const glm::ivec2 &value);
@@ -596,7 +954,8 @@ namespace Atlas {
 		struct BoundTextureInfo {
 			Texture2D texture;
 			TextureUsageBits usages;
-			int bindingPoint;
+			// resolved on bind if the shader was still compiling
+			mutable int bindingPoint{ -1 };
 		};
 
 		Ref<gl_utils::GLShader> m_Shader;
@@ -608,4 +967,25 @@ namespace Atlas {
 		VertexLayout m_Layout;
 	};
 
+	// compiles permutations of a shader on demand, one per set of defines
+	class ShaderVariantCache {
+	public:
+
+		ShaderVariantCache() = default;
+		ShaderVariantCache(const ShaderCreateInfo &info);
+
+		static ShaderVariantCache vert_frag(const std::string &vertexFile, const std::string &fragFile, const VertexLayout &layout, bool async = false);
+		static ShaderVariantCache comp(const std::string &file, bool async = false);
+
+		// defines are merged with the ones from the create info
+		Shader &get(const ShaderDefines &defines = {});
+
+		inline size_t size() const { return m_Variants.size(); }
+		inline bool is_init() const { return !m_Info.modules.empty(); }
+
+	private:
+		ShaderCreateInfo m_Info;
+		std::map<ShaderDefines, Shader> m_Variants;
+	};
+
 }
\ No newline at end of file
@@ -17,4 +17,29 @@ constexpr Ref<T> make_ref(Args&& ... args) {
 }
 
 template<typename T>
-using WeakRef = std::weak_ptr<T>;
\ No newline at end of file
+using WeakRef = std::weak_ptr<T>;
+
+// non owning view of contiguous memory, stand-in for C++20 std::span
+template<typename T>
+class Span {
+public:
+	constexpr Span() = default;
+	constexpr Span(T *data, size_t size) : m_Data(data), m_Size(size) {}
+
+	template<typename Container>
+	constexpr Span(Container &container) : m_Data(std::data(container)), m_Size(std::size(container)) {}
+
+	constexpr T *data() const { return m_Data; }
+	constexpr size_t size() const { return m_Size; }
+	constexpr size_t size_bytes() const { return m_Size * sizeof(T); }
+	constexpr bool empty() const { return m_Size == 0; }
+
+	constexpr T &operator[](size_t index) const { return m_Data[index]; }
+
+	constexpr T *begin() const { return m_Data; }
+	constexpr T *end() const { return m_Data + m_Size; }
+
+private:
+	T *m_Data{ nullptr };
+	size_t m_Size{ 0 };
+};
\ No newline at end of file
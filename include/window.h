@@ -14,6 +14,9 @@ namespace Atlas {
 		uint32_t width{ 0 }, height{ 0 };
 		EventCallbackFn eventCallback = default_event_callback_fn;
 		std::optional<std::vector<uint32_t>> icon{};
+
+		// no window and no swap chain, a surfaceless EGL context when built with ATLAS_HEADLESS_EGL
+		bool headless{ false };
 	};
 
 	class Window {
@@ -32,6 +35,9 @@ namespace Atlas {
 
 		void capture_mouse(bool enabled);
 
+		inline bool is_headless() const { return m_Headless; }
+		void request_close();
+
 		bool is_key_pressed(Atlas::KeyCode key);
 		bool is_mouse_button_pressed(int button);
 		bool is_minimized();
@@ -47,8 +53,18 @@ namespace Atlas {
 
 	private:
 		void init(const WindowCreateInfo &info);
+		void init_headless();
+		void destroy_headless();
+
+		GLFWwindow *m_Window{ nullptr };
+
+		bool m_Headless{ false };
+		bool m_CloseRequested{ false };
+		std::chrono::steady_clock::time_point m_StartTime;
 
-		GLFWwindow *m_Window;
+		// EGLDisplay and EGLContext, kept opaque so the egl headers stay out of here
+		void *m_EGLDisplay{ nullptr };
+		void *m_EGLContext{ nullptr };
 
 		std::string m_Title;
 		uint32_t m_Width{ 0 };
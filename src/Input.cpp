@@ -0,0 +1,140 @@
+#include "Input.h"
+
+#include <atomic>
+
+namespace Atlas::Input {
+
+	struct InputContext {
+		// written by events between frames, only touched by the main thread
+		std::bitset<512> keys;
+		std::bitset<512> keysPressed;
+		std::bitset<512> keysReleased;
+		uint8_t mouseButtons = 0;
+		uint8_t mousePressed = 0;
+		uint8_t mouseReleased = 0;
+
+		// new_frame writes the snapshot that isn't published, readers never see one being written
+		InputSnapshot snapshots[2];
+		std::atomic<uint32_t> current{ 0 };
+	};
+
+	static InputContext s_InputContext;
+
+	static inline bool valid_key(int key)
+	{
+		return key >= 0 && key < (int)s_InputContext.keys.size();
+	}
+
+	static inline bool valid_button(int button)
+	{
+		return button >= 0 && button < 8;
+	}
+
+	void on_event(const Event &event)
+	{
+		auto &ctx = s_InputContext;
+
+		switch (event.get_type()) {
+		case EventType::KeyPressed: {
+			auto &e = event.get<KeyPressedEvent>();
+			if (!valid_key(e.keyCode)) break;
+			if (!e.repeat) ctx.keysPressed.set(e.keyCode);
+			ctx.keys.set(e.keyCode);
+			break;
+		}
+		case EventType::KeyReleased: {
+			auto &e = event.get<KeyReleasedEvent>();
+			if (!valid_key(e.keyCode)) break;
+			ctx.keysReleased.set(e.keyCode);
+			ctx.keys.reset(e.keyCode);
+			break;
+		}
+		case EventType::MouseButtonPressed: {
+			auto &e = event.get<MouseButtonPressedEvent>();
+			if (!valid_button(e.button)) break;
+			ctx.mousePressed |= 1 << e.button;
+			ctx.mouseButtons |= 1 << e.button;
+			break;
+		}
+		case EventType::MouseButtonReleased: {
+			auto &e = event.get<MouseButtonReleasedEvent>();
+			if (!valid_button(e.button)) break;
+			ctx.mouseReleased |= 1 << e.button;
+			ctx.mouseButtons &= ~(1 << e.button);
+			break;
+		}
+		default: break;
+		}
+	}
+
+	void set_state(const std::bitset<512> &keys, uint8_t mouseButtons)
+	{
+		s_InputContext.keys = keys;
+		s_InputContext.mouseButtons = mouseButtons;
+	}
+
+	void new_frame(uint64_t frame, const glm::vec2 &mouse, bool viewportFocused, bool viewportHovered)
+	{
+		auto &ctx = s_InputContext;
+		uint32_t next = ctx.current.load(std::memory_order_relaxed) ^ 1;
+
+		InputSnapshot &snapshot = ctx.snapshots[next];
+		snapshot.frame = frame;
+		snapshot.keys = ctx.keys;
+		snapshot.keysPressed = ctx.keysPressed;
+		snapshot.keysReleased = ctx.keysReleased;
+		snapshot.mouseButtons = ctx.mouseButtons;
+		snapshot.mousePressed = ctx.mousePressed;
+		snapshot.mouseReleased = ctx.mouseReleased;
+		snapshot.mouse = mouse;
+		snapshot.viewportFocused = viewportFocused;
+		snapshot.viewportHovered = viewportHovered;
+
+		ctx.current.store(next, std::memory_order_release);
+
+		ctx.keysPressed.reset();
+		ctx.keysReleased.reset();
+		ctx.mousePressed = 0;
+		ctx.mouseReleased = 0;
+	}
+
+	const InputSnapshot &get_snapshot()
+	{
+		return s_InputContext.snapshots[s_InputContext.current.load(std::memory_order_acquire)];
+	}
+
+	bool is_key_down(KeyCode key)
+	{
+		return get_snapshot().is_key_down(key);
+	}
+
+	bool was_key_pressed(KeyCode key)
+	{
+		return valid_key((int)key) && get_snapshot().keysPressed.test((int)key);
+	}
+
+	bool was_key_released(KeyCode key)
+	{
+		return valid_key((int)key) && get_snapshot().keysReleased.test((int)key);
+	}
+
+	bool is_mouse_down(int button)
+	{
+		return get_snapshot().is_mouse_down(button);
+	}
+
+	bool was_mouse_pressed(int button)
+	{
+		return valid_button(button) && (get_snapshot().mousePressed >> button) & 1;
+	}
+
+	bool was_mouse_released(int button)
+	{
+		return valid_button(button) && (get_snapshot().mouseReleased >> button) & 1;
+	}
+
+	glm::vec2 get_mouse()
+	{
+		return get_snapshot().mouse;
+	}
+}
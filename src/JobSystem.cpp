@@ -0,0 +1,277 @@
+#include "JobSystem.h"
+
+#include <condition_variable>
+
+namespace Atlas::Jobs {
+
+	// the owner pushes and pops at the back, other threads steal the oldest jobs from the front
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+		std::thread thread;
+	};
+
+	struct JobContext {
+		bool init{ false };
+		std::thread::id mainThread;
+
+		// index 0 is the main thread, it only runs jobs while it waits
+		std::vector<Scope<Worker>> workers;
+		std::atomic<bool> running{ false };
+		std::atomic<uint32_t> nextWorker{ 0 };
+
+		std::atomic<uint32_t> queued{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+
+		std::mutex mainMutex;
+		std::vector<Job> mainJobs;
+	};
+
+	static JobContext s_JobContext;
+	static thread_local int s_WorkerIndex = -1;
+
+	static void execute(Job &job)
+	{
+		if (job.range) job.range(job.data, job.begin, job.end);
+		else job.func();
+		finish(job.counter);
+	}
+
+	static bool pop(uint32_t index, Job &job)
+	{
+		auto &workers = s_JobContext.workers;
+
+		{
+			Worker &own = *workers.at(index);
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.jobs.empty()) {
+				job = std::move(own.jobs.back());
+				own.jobs.pop_back();
+				s_JobContext.queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		for (uint32_t i = 1; i < workers.size(); i++) {
+			Worker &victim = *workers.at((index + i) % workers.size());
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty()) {
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				s_JobContext.queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static void worker_loop(uint32_t index)
+	{
+		OPTICK_THREAD("Worker");
+		s_WorkerIndex = (int)index;
+
+		Job job;
+		while (s_JobContext.running.load(std::memory_order_acquire)) {
+			if (pop(index, job)) {
+				execute(job);
+				job = Job{};
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(s_JobContext.sleepMutex);
+			s_JobContext.wake.wait(lock, []() {
+				return s_JobContext.queued.load(std::memory_order_relaxed) > 0 || !s_JobContext.running.load(std::memory_order_relaxed);
+			});
+		}
+	}
+
+	void init(uint32_t workers)
+	{
+		if (s_JobContext.init) {
+			CORE_WARN("Jobs::init: already initialized!");
+			return;
+		}
+
+		if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+		s_JobContext.init = true;
+		s_JobContext.mainThread = std::this_thread::get_id();
+		s_JobContext.running = true;
+		s_WorkerIndex = 0;
+
+		for (uint32_t i = 0; i <= workers; i++) s_JobContext.workers.push_back(make_scope<Worker>());
+		for (uint32_t i = 1; i <= workers; i++) s_JobContext.workers.at(i)->thread = std::thread(worker_loop, i);
+
+		CORE_INFO("Jobs: {} worker threads", workers);
+	}
+
+	void shutdown()
+	{
+		if (!s_JobContext.init) return;
+
+		// jobs that are still queued run on the main thread so their counters complete
+		execute_main_jobs();
+		Job job;
+		while (pop(0, job)) {
+			execute(job);
+			job = Job{};
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(s_JobContext.sleepMutex);
+			s_JobContext.running = false;
+		}
+		s_JobContext.wake.notify_all();
+
+		for (auto &worker : s_JobContext.workers) {
+			if (worker->thread.joinable()) worker->thread.join();
+		}
+
+		s_JobContext.workers.clear();
+		s_JobContext.init = false;
+	}
+
+	bool is_initialized()
+	{
+		return s_JobContext.init;
+	}
+
+	uint32_t get_thread_count()
+	{
+		return std::max(1u, (uint32_t)s_JobContext.workers.size());
+	}
+
+	int get_worker_index()
+	{
+		return s_WorkerIndex;
+	}
+
+	bool is_main_thread()
+	{
+		return !s_JobContext.init || std::this_thread::get_id() == s_JobContext.mainThread;
+	}
+
+	void add(Counter *counter, uint32_t count)
+	{
+		if (counter) counter->m_Value.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	void finish(Counter *counter)
+	{
+		if (!counter) return;
+
+		std::vector<Job> continuations;
+		{
+			// the waiter takes the lock before it returns, the counter can't be destroyed while it's held here
+			std::lock_guard<std::mutex> lock(counter->m_Mutex);
+			if (counter->m_Value.fetch_sub(1, std::memory_order_acq_rel) == 1) continuations = std::move(counter->m_Continuations);
+		}
+
+		for (auto &job : continuations) submit(std::move(job));
+	}
+
+	void submit(Job job)
+	{
+		// without workers everything runs inline
+		if (!s_JobContext.init) {
+			execute(job);
+			return;
+		}
+
+		uint32_t index = s_WorkerIndex >= 0 ? (uint32_t)s_WorkerIndex : s_JobContext.nextWorker.fetch_add(1, std::memory_order_relaxed) % get_thread_count();
+
+		{
+			Worker &worker = *s_JobContext.workers.at(index);
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			worker.jobs.push_back(std::move(job));
+		}
+
+		s_JobContext.queued.fetch_add(1, std::memory_order_relaxed);
+		{
+			// a worker about to sleep holds this while it checks queued, the wake up can't be missed
+			std::lock_guard<std::mutex> lock(s_JobContext.sleepMutex);
+		}
+		s_JobContext.wake.notify_one();
+	}
+
+	void run(std::function<void()> func, Counter *counter)
+	{
+		add(counter, 1);
+
+		Job job{};
+		job.func = std::move(func);
+		job.counter = counter;
+		submit(std::move(job));
+	}
+
+	void run_after(Counter &dependency, std::function<void()> func, Counter *counter)
+	{
+		add(counter, 1);
+
+		Job job{};
+		job.func = std::move(func);
+		job.counter = counter;
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+			if (!dependency.is_done()) {
+				dependency.m_Continuations.push_back(std::move(job));
+				return;
+			}
+		}
+
+		submit(std::move(job));
+	}
+
+	void run_on_main(std::function<void()> func, Counter *counter)
+	{
+		add(counter, 1);
+
+		Job job{};
+		job.func = std::move(func);
+		job.counter = counter;
+
+		std::lock_guard<std::mutex> lock(s_JobContext.mainMutex);
+		s_JobContext.mainJobs.push_back(std::move(job));
+	}
+
+	void execute_main_jobs()
+	{
+		CORE_ASSERT(is_main_thread(), "Jobs::execute_main_jobs: has to be called from the main thread");
+
+		std::vector<Job> jobs;
+		{
+			std::lock_guard<std::mutex> lock(s_JobContext.mainMutex);
+			if (s_JobContext.mainJobs.empty()) return;
+			jobs = std::move(s_JobContext.mainJobs);
+			s_JobContext.mainJobs.clear();
+		}
+
+		ATL_EVENT();
+		for (auto &job : jobs) execute(job);
+	}
+
+	void wait(Counter &counter)
+	{
+		bool mainThread = is_main_thread();
+		uint32_t index = s_WorkerIndex >= 0 ? (uint32_t)s_WorkerIndex : 0;
+
+		Job job;
+		while (!counter.is_done()) {
+			if (mainThread) execute_main_jobs();
+
+			if (s_JobContext.init && pop(index, job)) {
+				execute(job);
+				job = Job{};
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+
+		// the last finish may still hold the lock
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+	}
+}
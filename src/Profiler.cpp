@@ -0,0 +1,682 @@
+#include "Profiler.h"
+
+#include "gl_utils.h"
+#include "RenderApi.h"
+
+#include <imgui.h>
+
+#include <atomic>
+
+// GL_ARB_pipeline_statistics_query, core since 4.6 but not part of the generated glad loader
+#define GL_VERTICES_SUBMITTED_ARB 0x82EE
+#define GL_PRIMITIVES_SUBMITTED_ARB 0x82EF
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#define GL_COMPUTE_SHADER_INVOCATIONS_ARB 0x82F5
+#define GL_CLIPPING_INPUT_PRIMITIVES_ARB 0x82F6
+
+namespace Atlas::Profiler {
+
+	static constexpr GLenum s_StatisticTargets[] = {
+		GL_VERTICES_SUBMITTED_ARB,
+		GL_PRIMITIVES_SUBMITTED_ARB,
+		GL_VERTEX_SHADER_INVOCATIONS_ARB,
+		GL_CLIPPING_INPUT_PRIMITIVES_ARB,
+		GL_FRAGMENT_SHADER_INVOCATIONS_ARB,
+		GL_COMPUTE_SHADER_INVOCATIONS_ARB,
+	};
+	static constexpr uint32_t STATISTIC_COUNT = sizeof(s_StatisticTargets) / sizeof(GLenum);
+
+	struct PendingScope {
+		const char *name;
+		uint32_t depth;
+		uint32_t beginQuery;
+		uint32_t endQuery;
+	};
+
+	// queries of one frame, reused once the frame retired
+	struct FrameQueries {
+		uint64_t frameIndex{ 0 };
+
+		std::vector<uint32_t> timestamps;
+		uint32_t usedTimestamps{ 0 };
+		std::vector<PendingScope> scopes;
+
+		std::array<uint32_t, STATISTIC_COUNT> statistics{};
+		bool hasStatistics{ false };
+	};
+
+	struct GpuProfilerData {
+		bool init{ false };
+		bool enabled{ true };
+		bool statisticsSupported{ false };
+		bool statisticsEnabled{ false };
+
+		std::vector<Scope<FrameQueries>> freeFrames;
+		Scope<FrameQueries> current;
+		std::vector<uint32_t> scopeStack;
+
+		GpuFrameResult lastFrame;
+
+		// GPU timestamp and CPU high precision time taken at the same moment, maps GPU events into the trace
+		int64_t gpuClockOffset{ 0 };
+
+#ifdef ATL_PROFILE
+		Optick::EventStorage *storage{ nullptr };
+		std::unordered_map<std::string, Optick::EventDescription *> descriptions;
+#endif
+	};
+
+	static GpuProfilerData s_GpuData;
+
+	static void resolve_frame_gpu(const GpuFrameResult &result);
+
+	static uint32_t push_timestamp(FrameQueries &frame)
+	{
+		if (frame.usedTimestamps == frame.timestamps.size()) {
+			uint32_t id = 0;
+			glCreateQueries(GL_TIMESTAMP, 1, &id);
+			frame.timestamps.push_back(id);
+		}
+
+		uint32_t index = frame.usedTimestamps++;
+		glQueryCounter(frame.timestamps.at(index), GL_TIMESTAMP);
+		return index;
+	}
+
+	static uint64_t get_timestamp(const FrameQueries &frame, uint32_t index)
+	{
+		GLuint64 value = 0;
+		glGetQueryObjectui64v(frame.timestamps.at(index), GL_QUERY_RESULT, &value);
+		return value;
+	}
+
+#ifdef ATL_PROFILE
+	static void export_to_trace(const FrameQueries &frame)
+	{
+		if (!Optick::IsActive()) return;
+
+		for (auto &scope : frame.scopes) {
+			auto it = s_GpuData.descriptions.find(scope.name);
+			if (it == s_GpuData.descriptions.end()) {
+				it = s_GpuData.descriptions.insert({ scope.name, Optick::EventDescription::CreateShared(scope.name) }).first;
+			}
+
+			// nanoseconds on the GPU clock to ticks of the CPU clock optick uses
+			double ticksPerNs = (double)Optick::GetHighPrecisionFrequency() / 1e9;
+			int64_t start = (int64_t)((int64_t)get_timestamp(frame, scope.beginQuery) * ticksPerNs) + s_GpuData.gpuClockOffset;
+			int64_t end = (int64_t)((int64_t)get_timestamp(frame, scope.endQuery) * ticksPerNs) + s_GpuData.gpuClockOffset;
+
+			OPTICK_STORAGE_EVENT(s_GpuData.storage, it->second, start, end);
+		}
+	}
+#endif
+
+	static void resolve(Scope<FrameQueries> frame)
+	{
+		ATL_EVENT();
+		GpuFrameResult result{};
+		result.frameIndex = frame->frameIndex;
+
+		if (!frame->scopes.empty()) {
+			// the first and the last timestamp enclose the frame
+			uint64_t frameStart = get_timestamp(*frame, 0);
+			uint64_t frameEnd = get_timestamp(*frame, frame->usedTimestamps - 1);
+			result.gpuMs = (float)((frameEnd - frameStart) / 1e6);
+
+			// scope 0 is the frame itself
+			for (size_t i = 1; i < frame->scopes.size(); i++) {
+				auto &scope = frame->scopes.at(i);
+				uint64_t begin = get_timestamp(*frame, scope.beginQuery);
+				uint64_t end = get_timestamp(*frame, scope.endQuery);
+
+				GpuScopeResult scopeResult{};
+				scopeResult.name = scope.name;
+				scopeResult.depth = scope.depth - 1;
+				scopeResult.startMs = (float)((begin - frameStart) / 1e6);
+				scopeResult.durationMs = (float)((end - begin) / 1e6);
+				result.scopes.push_back(scopeResult);
+			}
+
+#ifdef ATL_PROFILE
+			export_to_trace(*frame);
+#endif
+		}
+
+		if (frame->hasStatistics) {
+			std::array<GLuint64, STATISTIC_COUNT> values{};
+			for (uint32_t i = 0; i < STATISTIC_COUNT; i++) {
+				glGetQueryObjectui64v(frame->statistics.at(i), GL_QUERY_RESULT, &values.at(i));
+			}
+
+			result.hasStatistics = true;
+			result.statistics.verticesSubmitted = values.at(0);
+			result.statistics.primitivesSubmitted = values.at(1);
+			result.statistics.vertexShaderInvocations = values.at(2);
+			result.statistics.clippingInputPrimitives = values.at(3);
+			result.statistics.fragmentShaderInvocations = values.at(4);
+			result.statistics.computeShaderInvocations = values.at(5);
+		}
+
+		resolve_frame_gpu(result);
+		s_GpuData.lastFrame = std::move(result);
+		s_GpuData.freeFrames.push_back(std::move(frame));
+	}
+
+	void init()
+	{
+		if (s_GpuData.init) return;
+		s_GpuData.init = true;
+
+		s_GpuData.statisticsSupported = gl_utils::has_extension("GL_ARB_pipeline_statistics_query");
+
+		// names the CPU scopes of hitches
+		ScopeTimer::set_recording(true);
+
+#ifdef ATL_PROFILE
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		double ticksPerNs = (double)Optick::GetHighPrecisionFrequency() / 1e9;
+		s_GpuData.gpuClockOffset = Optick::GetHighPrecisionTime() - (int64_t)(gpuNow * ticksPerNs);
+		s_GpuData.storage = OPTICK_STORAGE_REGISTER("GPU");
+#endif
+	}
+
+	void frame_start()
+	{
+		if (!s_GpuData.init || !s_GpuData.enabled) return;
+
+		if (!s_GpuData.freeFrames.empty()) {
+			s_GpuData.current = std::move(s_GpuData.freeFrames.back());
+			s_GpuData.freeFrames.pop_back();
+		}
+		else {
+			s_GpuData.current = make_scope<FrameQueries>();
+		}
+
+		auto &frame = *s_GpuData.current;
+		frame.frameIndex = Render::get_frame_index();
+		frame.usedTimestamps = 0;
+		frame.scopes.clear();
+		frame.hasStatistics = false;
+
+		if (s_GpuData.statisticsEnabled) {
+			if (frame.statistics.at(0) == 0) {
+				for (uint32_t i = 0; i < STATISTIC_COUNT; i++) glCreateQueries(s_StatisticTargets[i], 1, &frame.statistics.at(i));
+			}
+
+			for (uint32_t i = 0; i < STATISTIC_COUNT; i++) glBeginQuery(s_StatisticTargets[i], frame.statistics.at(i));
+			frame.hasStatistics = true;
+		}
+
+		s_GpuData.scopeStack.clear();
+		gpu_begin("frame");
+	}
+
+	void frame_end()
+	{
+		if (!s_GpuData.current) return;
+
+		while (!s_GpuData.scopeStack.empty()) gpu_end();
+
+		if (s_GpuData.current->hasStatistics) {
+			for (uint32_t i = 0; i < STATISTIC_COUNT; i++) glEndQuery(s_StatisticTargets[i]);
+		}
+
+		// queries are complete once the fence of this frame signaled, reading them never stalls
+		FrameQueries *frame = s_GpuData.current.release();
+		Render::on_frame_retired([frame]() { resolve(Scope<FrameQueries>(frame)); });
+	}
+
+	void gpu_begin(const char *name)
+	{
+		if (!s_GpuData.current) return;
+
+		auto &frame = *s_GpuData.current;
+
+		PendingScope scope{};
+		scope.name = name;
+		scope.depth = (uint32_t)s_GpuData.scopeStack.size();
+		scope.beginQuery = push_timestamp(frame);
+
+		s_GpuData.scopeStack.push_back((uint32_t)frame.scopes.size());
+		frame.scopes.push_back(scope);
+	}
+
+	void gpu_end()
+	{
+		if (!s_GpuData.current || s_GpuData.scopeStack.empty()) return;
+
+		auto &frame = *s_GpuData.current;
+		frame.scopes.at(s_GpuData.scopeStack.back()).endQuery = push_timestamp(frame);
+		s_GpuData.scopeStack.pop_back();
+	}
+
+	void enable_gpu_timing(bool enable)
+	{
+		s_GpuData.enabled = enable;
+	}
+
+	bool is_gpu_timing_enabled()
+	{
+		return s_GpuData.enabled;
+	}
+
+	void enable_pipeline_statistics(bool enable)
+	{
+		if (enable && !s_GpuData.statisticsSupported) {
+			CORE_WARN("Profiler::enable_pipeline_statistics: GL_ARB_pipeline_statistics_query is not supported");
+			return;
+		}
+
+		s_GpuData.statisticsEnabled = enable;
+	}
+
+	bool has_pipeline_statistics()
+	{
+		return s_GpuData.statisticsSupported;
+	}
+
+	const GpuFrameResult &get_gpu_frame()
+	{
+		return s_GpuData.lastFrame;
+	}
+
+	void show_gpu_timeline()
+	{
+		const auto &frame = s_GpuData.lastFrame;
+
+		ImGui::Begin("GPU Profiler");
+
+		bool enabled = s_GpuData.enabled;
+		if (ImGui::Checkbox("enabled", &enabled)) enable_gpu_timing(enabled);
+
+		if (s_GpuData.statisticsSupported) {
+			ImGui::SameLine();
+			bool statistics = s_GpuData.statisticsEnabled;
+			if (ImGui::Checkbox("pipeline statistics", &statistics)) enable_pipeline_statistics(statistics);
+		}
+
+		ImGui::Text("frame %llu: %.3f ms", (unsigned long long)frame.frameIndex, frame.gpuMs);
+
+		// one row per nesting level, scaled to the frame
+		const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+		const float width = ImGui::GetContentRegionAvail().x;
+		uint32_t maxDepth = 0;
+		for (auto &scope : frame.scopes) maxDepth = std::max(maxDepth, scope.depth);
+
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImDrawList *drawList = ImGui::GetWindowDrawList();
+		float scale = frame.gpuMs > 0 ? width / frame.gpuMs : 0;
+
+		for (auto &scope : frame.scopes) {
+			ImVec2 min(origin.x + scope.startMs * scale, origin.y + scope.depth * rowHeight);
+			ImVec2 max(min.x + std::max(scope.durationMs * scale, 1.0f), min.y + rowHeight - 1);
+
+			ImU32 color = ImGui::GetColorU32(ImVec4(0.25f + 0.15f * (scope.depth % 4), 0.45f, 0.75f, 1.0f));
+			drawList->AddRectFilled(min, max, color);
+			drawList->PushClipRect(min, max, true);
+			drawList->AddText(ImVec2(min.x + 2, min.y), IM_COL32_WHITE, scope.name);
+			drawList->PopClipRect();
+
+			if (ImGui::IsMouseHoveringRect(min, max)) ImGui::SetTooltip("%s: %.3f ms", scope.name, scope.durationMs);
+		}
+
+		ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight));
+
+		for (auto &scope : frame.scopes) {
+			ImGui::Text("%*s%s: %.3f ms", (int)scope.depth * 2, "", scope.name, scope.durationMs);
+		}
+
+		if (frame.hasStatistics) {
+			ImGui::Separator();
+			ImGui::Text("vertices submitted: %llu", (unsigned long long)frame.statistics.verticesSubmitted);
+			ImGui::Text("primitives submitted: %llu", (unsigned long long)frame.statistics.primitivesSubmitted);
+			ImGui::Text("vertex invocations: %llu", (unsigned long long)frame.statistics.vertexShaderInvocations);
+			ImGui::Text("clipping input primitives: %llu", (unsigned long long)frame.statistics.clippingInputPrimitives);
+			ImGui::Text("fragment invocations: %llu", (unsigned long long)frame.statistics.fragmentShaderInvocations);
+			ImGui::Text("compute invocations: %llu", (unsigned long long)frame.statistics.computeShaderInvocations);
+		}
+
+		ImGui::End();
+	}
+}
+
+namespace Atlas::Profiler {
+
+	static constexpr uint32_t MAX_HITCHES = 32;
+	static constexpr uint32_t MAX_HITCH_SCOPES = 8;
+
+	// one frame of the ring, frameIndex is cleared while the slot is rewritten so readers can drop torn copies
+	struct FrameSlot {
+		std::atomic<uint64_t> frameIndex{ UINT64_MAX };
+		std::atomic<float> cpuMs{ 0 };
+		std::atomic<float> gpuMs{ -1 };
+		std::atomic<float> presentMs{ 0 };
+		std::atomic<bool> overBudget{ false };
+	};
+
+	struct HistoryEntry {
+		FrameRecord record;
+		std::string scopes;
+	};
+
+	struct FrameStatsData {
+		std::array<FrameSlot, FRAME_RING_SIZE> ring;
+		std::atomic<uint64_t> written{ 0 };
+
+		std::atomic<float> budgetMs{ 1000.0f / 60.0f };
+
+		std::deque<Hitch> hitches;
+		std::vector<ScopeTimer::Record> scopeRecords;
+
+		bool keepHistory{ false };
+		std::vector<HistoryEntry> history;
+	};
+
+	static FrameStatsData s_FrameData;
+
+	static std::vector<ScopeTime> longest_scopes(const std::vector<ScopeTimer::Record> &records)
+	{
+		std::vector<ScopeTime> scopes;
+		scopes.reserve(records.size());
+		for (auto &record : records) {
+			scopes.push_back({ record.name, record.depth, (float)((record.endNs - record.startNs) / 1e6) });
+		}
+
+		size_t count = std::min<size_t>(scopes.size(), MAX_HITCH_SCOPES);
+		std::partial_sort(scopes.begin(), scopes.begin() + count, scopes.end(), [](const ScopeTime &a, const ScopeTime &b) { return a.ms > b.ms; });
+		scopes.resize(count);
+		return scopes;
+	}
+
+	static std::string join_scopes(const Hitch &hitch)
+	{
+		std::stringstream ss;
+		for (auto &scope : hitch.cpuScopes) ss << scope.name << "=" << scope.ms << ";";
+		for (auto &scope : hitch.gpuScopes) ss << "gpu:" << scope.name << "=" << scope.durationMs << ";";
+		return ss.str();
+	}
+
+	static HistoryEntry *find_history(uint64_t frameIndex)
+	{
+		// GPU results arrive a few frames late, the entry is near the back
+		auto &history = s_FrameData.history;
+		for (auto it = history.rbegin(); it != history.rend(); it++) {
+			if (it->record.frameIndex == frameIndex) return &*it;
+			if (it->record.frameIndex < frameIndex) break;
+		}
+		return nullptr;
+	}
+
+	static Hitch *find_hitch(uint64_t frameIndex)
+	{
+		for (auto &hitch : s_FrameData.hitches) {
+			if (hitch.frameIndex == frameIndex) return &hitch;
+		}
+		return nullptr;
+	}
+
+	static Hitch &push_hitch(uint64_t frameIndex)
+	{
+		if (s_FrameData.hitches.size() == MAX_HITCHES) s_FrameData.hitches.pop_front();
+		s_FrameData.hitches.push_back({});
+		s_FrameData.hitches.back().frameIndex = frameIndex;
+		return s_FrameData.hitches.back();
+	}
+
+	void record_frame(uint64_t frameIndex, float cpuMs, float presentMs)
+	{
+		float budget = s_FrameData.budgetMs.load(std::memory_order_relaxed);
+		// a swap waiting on vsync near the budget isn't a hitch, only the work of the frame counts
+		bool overBudget = cpuMs > budget;
+
+		uint64_t position = s_FrameData.written.load(std::memory_order_relaxed);
+		FrameSlot &slot = s_FrameData.ring.at(position % FRAME_RING_SIZE);
+		slot.frameIndex.store(UINT64_MAX, std::memory_order_release);
+		slot.cpuMs.store(cpuMs, std::memory_order_relaxed);
+		slot.gpuMs.store(-1, std::memory_order_relaxed);
+		slot.presentMs.store(presentMs, std::memory_order_relaxed);
+		slot.overBudget.store(overBudget, std::memory_order_relaxed);
+		slot.frameIndex.store(frameIndex, std::memory_order_release);
+		s_FrameData.written.store(position + 1, std::memory_order_release);
+
+		ScopeTimer::take_records(s_FrameData.scopeRecords);
+
+		Hitch *hitch = nullptr;
+		if (overBudget) {
+			hitch = &push_hitch(frameIndex);
+			hitch->cpuMs = cpuMs;
+			hitch->presentMs = presentMs;
+			hitch->cpuScopes = longest_scopes(s_FrameData.scopeRecords);
+		}
+
+		if (s_FrameData.keepHistory) {
+			HistoryEntry entry{};
+			entry.record = { frameIndex, cpuMs, -1, presentMs, overBudget };
+			if (hitch) entry.scopes = join_scopes(*hitch);
+			s_FrameData.history.push_back(std::move(entry));
+		}
+	}
+
+	static void resolve_frame_gpu(const GpuFrameResult &result)
+	{
+		float budget = s_FrameData.budgetMs.load(std::memory_order_relaxed);
+		bool gpuOverBudget = result.gpuMs > budget;
+
+		// the frame retired within the last few records, older slots were already overwritten
+		uint64_t written = s_FrameData.written.load(std::memory_order_relaxed);
+		bool overBudget = gpuOverBudget;
+		FrameSlot *frameSlot = nullptr;
+		for (uint64_t i = 0; i < std::min<uint64_t>(written, 8); i++) {
+			FrameSlot &slot = s_FrameData.ring.at((written - 1 - i) % FRAME_RING_SIZE);
+			if (slot.frameIndex.load(std::memory_order_relaxed) != result.frameIndex) continue;
+
+			slot.gpuMs.store(result.gpuMs, std::memory_order_relaxed);
+			overBudget |= slot.overBudget.load(std::memory_order_relaxed);
+			slot.overBudget.store(overBudget, std::memory_order_relaxed);
+			frameSlot = &slot;
+			break;
+		}
+
+		Hitch *hitch = find_hitch(result.frameIndex);
+		if (gpuOverBudget && !hitch) {
+			hitch = &push_hitch(result.frameIndex);
+			if (frameSlot) {
+				hitch->cpuMs = frameSlot->cpuMs.load(std::memory_order_relaxed);
+				hitch->presentMs = frameSlot->presentMs.load(std::memory_order_relaxed);
+			}
+		}
+
+		if (hitch) {
+			hitch->gpuMs = result.gpuMs;
+			hitch->gpuScopes = result.scopes;
+			std::sort(hitch->gpuScopes.begin(), hitch->gpuScopes.end(), [](const GpuScopeResult &a, const GpuScopeResult &b) { return a.durationMs > b.durationMs; });
+			if (hitch->gpuScopes.size() > MAX_HITCH_SCOPES) hitch->gpuScopes.resize(MAX_HITCH_SCOPES);
+		}
+
+		if (s_FrameData.keepHistory) {
+			if (HistoryEntry *entry = find_history(result.frameIndex)) {
+				entry->record.gpuMs = result.gpuMs;
+				entry->record.overBudget |= gpuOverBudget;
+				if (hitch) entry->scopes = join_scopes(*hitch);
+			}
+		}
+	}
+
+	void set_frame_budget(float ms)
+	{
+		s_FrameData.budgetMs.store(ms, std::memory_order_relaxed);
+	}
+
+	float get_frame_budget()
+	{
+		return s_FrameData.budgetMs.load(std::memory_order_relaxed);
+	}
+
+	std::vector<FrameRecord> get_frame_records()
+	{
+		std::vector<FrameRecord> records;
+
+		uint64_t written = s_FrameData.written.load(std::memory_order_acquire);
+		uint64_t count = std::min<uint64_t>(written, FRAME_RING_SIZE);
+		records.reserve((size_t)count);
+
+		for (uint64_t position = written - count; position < written; position++) {
+			const FrameSlot &slot = s_FrameData.ring.at(position % FRAME_RING_SIZE);
+
+			FrameRecord record{};
+			record.frameIndex = slot.frameIndex.load(std::memory_order_acquire);
+			record.cpuMs = slot.cpuMs.load(std::memory_order_relaxed);
+			record.gpuMs = slot.gpuMs.load(std::memory_order_relaxed);
+			record.presentMs = slot.presentMs.load(std::memory_order_relaxed);
+			record.overBudget = slot.overBudget.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// rewritten while copying
+			if (record.frameIndex == UINT64_MAX || slot.frameIndex.load(std::memory_order_relaxed) != record.frameIndex) continue;
+			records.push_back(record);
+		}
+
+		return records;
+	}
+
+	static Percentiles compute_percentiles(std::vector<float> &values)
+	{
+		Percentiles result{};
+		if (values.empty()) return result;
+
+		std::sort(values.begin(), values.end());
+		auto rank = [&](float p) { return values.at(std::min(values.size() - 1, (size_t)(p * values.size()))); };
+		result.p50 = rank(0.50f);
+		result.p95 = rank(0.95f);
+		result.p99 = rank(0.99f);
+		result.max = values.back();
+		return result;
+	}
+
+	FrameStatistics get_frame_statistics()
+	{
+		auto records = get_frame_records();
+
+		std::vector<float> cpu, gpu, present;
+		cpu.reserve(records.size());
+		gpu.reserve(records.size());
+		present.reserve(records.size());
+
+		FrameStatistics stats{};
+		for (auto &record : records) {
+			cpu.push_back(record.cpuMs);
+			present.push_back(record.presentMs);
+			if (record.gpuMs >= 0) gpu.push_back(record.gpuMs);
+			if (record.overBudget) stats.overBudget++;
+		}
+
+		stats.frameCount = (uint32_t)records.size();
+		stats.cpu = compute_percentiles(cpu);
+		stats.gpu = compute_percentiles(gpu);
+		stats.present = compute_percentiles(present);
+		return stats;
+	}
+
+	const std::deque<Hitch> &get_hitches()
+	{
+		return s_FrameData.hitches;
+	}
+
+	void keep_frame_history(bool keep)
+	{
+		s_FrameData.keepHistory = keep;
+		if (!keep) s_FrameData.history.clear();
+	}
+
+	bool write_frame_csv(const std::string &path)
+	{
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			CORE_WARN("Profiler::write_frame_csv: could not open {}", path);
+			return false;
+		}
+
+		file << "frame,cpu_ms,gpu_ms,present_ms,over_budget,scopes\n";
+
+		auto write = [&](const FrameRecord &record, const std::string &scopes) {
+			file << record.frameIndex << "," << record.cpuMs << ",";
+			if (record.gpuMs >= 0) file << record.gpuMs;
+			file << "," << record.presentMs << "," << (record.overBudget ? 1 : 0) << "," << scopes << "\n";
+		};
+
+		if (s_FrameData.keepHistory) {
+			for (auto &entry : s_FrameData.history) write(entry.record, entry.scopes);
+		}
+		else {
+			for (auto &record : get_frame_records()) write(record, "");
+		}
+
+		CORE_INFO("Profiler: wrote frame statistics to {}", path);
+		return true;
+	}
+
+	static void show_percentiles(const char *label, const Percentiles &p)
+	{
+		ImGui::Text("%-8s p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms", label, p.p50, p.p95, p.p99, p.max);
+	}
+
+	static void show_histogram(const char *label, const std::vector<float> &values, float maxMs)
+	{
+		constexpr uint32_t BUCKETS = 48;
+		std::array<float, BUCKETS> buckets{};
+		if (maxMs <= 0) return;
+
+		for (float value : values) {
+			if (value < 0) continue;
+			uint32_t bucket = std::min(BUCKETS - 1, (uint32_t)(value / maxMs * BUCKETS));
+			buckets.at(bucket) += 1;
+		}
+
+		std::string overlay = "0 - " + std::to_string((int)std::ceil(maxMs)) + " ms";
+		ImGui::PlotHistogram(label, buckets.data(), BUCKETS, 0, overlay.c_str(), 0, 3.4e38f, ImVec2(0, 60));
+	}
+
+	void show_frame_statistics()
+	{
+		auto records = get_frame_records();
+		auto stats = get_frame_statistics();
+
+		ImGui::Begin("Frame Statistics");
+
+		float budget = get_frame_budget();
+		if (ImGui::SliderFloat("budget ms", &budget, 1.0f, 100.0f)) set_frame_budget(budget);
+
+		ImGui::Text("%u frames, %u over budget", stats.frameCount, stats.overBudget);
+		show_percentiles("cpu", stats.cpu);
+		show_percentiles("gpu", stats.gpu);
+		show_percentiles("present", stats.present);
+
+		std::vector<float> cpu, gpu, present;
+		for (auto &record : records) {
+			cpu.push_back(record.cpuMs);
+			gpu.push_back(std::max(record.gpuMs, 0.0f));
+			present.push_back(record.presentMs);
+		}
+
+		float maxMs = std::max({ stats.cpu.max, stats.gpu.max, stats.present.max, budget });
+		ImGui::PlotLines("cpu", cpu.data(), (int)cpu.size(), 0, nullptr, 0, maxMs, ImVec2(0, 60));
+		ImGui::PlotLines("gpu", gpu.data(), (int)gpu.size(), 0, nullptr, 0, maxMs, ImVec2(0, 60));
+		ImGui::PlotLines("present", present.data(), (int)present.size(), 0, nullptr, 0, maxMs, ImVec2(0, 60));
+
+		show_histogram("cpu distribution", cpu, maxMs);
+		show_histogram("gpu distribution", gpu, maxMs);
+		show_histogram("present distribution", present, maxMs);
+
+		if (ImGui::CollapsingHeader("hitches")) {
+			for (auto it = s_FrameData.hitches.rbegin(); it != s_FrameData.hitches.rend(); it++) {
+				ImGui::Text("frame %llu: cpu %.3f ms, gpu %.3f ms, present %.3f ms", (unsigned long long)it->frameIndex, it->cpuMs, it->gpuMs, it->presentMs);
+				for (auto &scope : it->cpuScopes) ImGui::Text("    %s: %.3f ms", scope.name, scope.ms);
+				for (auto &scope : it->gpuScopes) ImGui::Text("    gpu %s: %.3f ms", scope.name, scope.durationMs);
+			}
+		}
+
+		ImGui::End();
+	}
+}
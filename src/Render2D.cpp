@@ -6,6 +6,7 @@
 #include "RenderApi.h"
 #include "camera.h"
 #include "atl_types.h"
+#include "Profiler.h"
 
 namespace Atlas::Render2D {
 
@@ -62,8 +63,8 @@ namespace Atlas::Render2D {
 		auto layout = VertexLayout::from(&Vertex::pos, &Vertex::uv, &Vertex::color, &Vertex::texID, &Vertex::isEllipse);
 		s_RenderData.shader = Shader::load_vert_frag("assets/shaders/default.vert", "assets/shaders/default.frag", layout);
 
-		s_RenderData.vertexBuffer = Buffer::vertex<Vertex>(RenderData::MAX_VERTICES, BufferUsage::DYNAMIC);
-		s_RenderData.indexBuffer = Buffer::index(RenderData::MAX_INDICES, BufferUsage::DYNAMIC);
+		s_RenderData.vertexBuffer = Buffer::vertex<Vertex>(RenderData::MAX_VERTICES, BufferUsage::STREAM);
+		s_RenderData.indexBuffer = Buffer::index(RenderData::MAX_INDICES, BufferUsage::STREAM);
 
 		//TODO: generate buffer in shader?
 		Buffer cameraBuffer = Buffer::uniform(glm::ortho(-1, 1, -1, 1), BufferUsage::DYNAMIC);
@@ -256,10 +257,11 @@ namespace Atlas::Render2D {
 	}
 
 	void flush() {
-		ATL_EVENT();
+		ATL_GPU_EVENT("Render2D::flush");
 		s_RenderData.stats.drawCalls++;
-		s_RenderData.vertexBuffer.set_data(s_RenderData.vertices.data(), s_RenderData.vertexCount * sizeof(Vertex));
-		s_RenderData.indexBuffer.set_data(s_RenderData.indices.data(), s_RenderData.indexCount * sizeof(uint32_t));
+		// only the part of the batch that was filled
+		s_RenderData.vertexBuffer.set_data(0, Span<const Vertex>(s_RenderData.vertices.data(), s_RenderData.vertexCount));
+		s_RenderData.indexBuffer.set_data(0, Span<const uint32_t>(s_RenderData.indices.data(), s_RenderData.indexCount));
 
 		Shader::bind(s_RenderData.shader);
 		Buffer::bind_index(s_RenderData.indexBuffer);
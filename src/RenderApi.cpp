@@ -1,6 +1,7 @@
 #include "RenderApi.h"
 
 #include "gl_utils.h"
+#include "Profiler.h"
 
 namespace Atlas {
 
@@ -26,8 +27,21 @@ namespace Atlas {
 			bool used{ false };
 		};
 
+		struct InFlightFrame {
+			uint64_t index;
+			Fence fence;
+			std::vector<std::function<void()>> callbacks;
+		};
+
 		struct RenderContext {
 			std::unordered_map<size_t, CachedFramebuffer> framebuffers;
+
+			std::deque<InFlightFrame> inFlight;
+			std::vector<std::function<void()>> frameCallbacks;
+			uint32_t framesInFlight{ 2 };
+			uint64_t frameIndex{ 0 };
+			uint64_t retiredFrame{ 0 };
+
 			bool clearColorBuffer{ true };
 			bool clearDepthBuffer{ true };
 			glm::vec4 clearColor{ 0, 0, 0, 0 };
@@ -98,8 +112,38 @@ namespace Atlas {
 			glClear(s_GlobalRenderContext.clearColorBuffer ? GL_COLOR_BUFFER_BIT : 0 || s_GlobalRenderContext.clearDepthBuffer ? GL_DEPTH_BUFFER_BIT : 0);
 		}
 
+		static constexpr uint64_t FENCE_TIMEOUT_NS = 1000000000;
+
+		static void retire_frames(uint32_t maxInFlight)
+		{
+			auto &inFlight = s_GlobalRenderContext.inFlight;
+
+			while (!inFlight.empty()) {
+				InFlightFrame &frame = inFlight.front();
+				if (inFlight.size() > maxInFlight) {
+					// the callbacks release what the frame used, they may only run once the GPU is really done with it
+					while (!frame.fence.wait(FENCE_TIMEOUT_NS)) {
+						CORE_WARN("Render::retire_frames: frame {} did not finish within {} ms, waiting again", frame.index, FENCE_TIMEOUT_NS / 1000000);
+					}
+				}
+				else if (!frame.fence.is_signaled()) break;
+
+				// callbacks may register new callbacks for the current frame, don't hold references
+				InFlightFrame retired = std::move(frame);
+				inFlight.pop_front();
+
+				s_GlobalRenderContext.retiredFrame = retired.index;
+				for (auto &func : retired.callbacks) func();
+			}
+		}
+
 		void frame_start()
 		{
+			ATL_EVENT();
+			// the frame about to be recorded counts as in flight too
+			retire_frames(s_GlobalRenderContext.framesInFlight - 1);
+			Profiler::frame_start();
+
 			for (auto &it : s_GlobalRenderContext.framebuffers) {
 				it.second.used = false;
 			}
@@ -115,6 +159,56 @@ namespace Atlas {
 				else it++;
 			}
 
+			Profiler::frame_end();
+
+			InFlightFrame frame{};
+			frame.index = s_GlobalRenderContext.frameIndex++;
+			frame.fence = Fence::insert();
+			frame.callbacks = std::move(s_GlobalRenderContext.frameCallbacks);
+			s_GlobalRenderContext.frameCallbacks.clear();
+			s_GlobalRenderContext.inFlight.push_back(std::move(frame));
+		}
+
+		void set_frames_in_flight(uint32_t count)
+		{
+			CORE_ASSERT(count >= 1 && count <= 3, "Render::set_frames_in_flight: count has to be between 1 and 3, it is {}", count);
+			s_GlobalRenderContext.framesInFlight = count;
+		}
+
+		uint32_t get_frames_in_flight()
+		{
+			return s_GlobalRenderContext.framesInFlight;
+		}
+
+		uint64_t get_frame_index()
+		{
+			return s_GlobalRenderContext.frameIndex;
+		}
+
+		uint64_t get_retired_frame()
+		{
+			return s_GlobalRenderContext.retiredFrame;
+		}
+
+		void on_frame_retired(std::function<void()> func)
+		{
+			s_GlobalRenderContext.frameCallbacks.push_back(std::move(func));
+		}
+
+		void wait_idle()
+		{
+			ATL_EVENT();
+			// work recorded outside of a frame gets its own fence
+			if (!s_GlobalRenderContext.frameCallbacks.empty()) {
+				InFlightFrame frame{};
+				frame.index = s_GlobalRenderContext.frameIndex;
+				frame.fence = Fence::insert();
+				frame.callbacks = std::move(s_GlobalRenderContext.frameCallbacks);
+				s_GlobalRenderContext.frameCallbacks.clear();
+				s_GlobalRenderContext.inFlight.push_back(std::move(frame));
+			}
+
+			retire_frames(0);
 		}
 
 		void enable_clear_color(bool b)
@@ -180,12 +274,28 @@ namespace Atlas {
 		void init()
 		{
 			gl_utils::init_opengl();
+			Profiler::init();
+
+			// set by the build when it compiles the shaders to SPIR-V
+#ifdef ATLAS_SPIRV_DIR
+			gl_utils::set_spirv_dir(ATLAS_SPIRV_DIR);
+#endif
 		}
 
 		void resize_viewport(uint32_t width, uint32_t height)
 		{
 			gl_utils::resize_viewport(width, height);
 		}
+
+		void set_shader_cache_dir(const std::string &directory)
+		{
+			gl_utils::set_program_cache_dir(directory);
+		}
+
+		void set_spirv_dir(const std::string &directory)
+		{
+			gl_utils::set_spirv_dir(directory);
+		}
 	}
 
 }
@@ -10,6 +10,9 @@
 #include "RenderApi.h"
 
 #include "Render2D.h"
+#include "Profiler.h"
+#include "event_recorder.h"
+#include "EventQueue.h"
 
 static const std::vector<uint32_t> s_Logo = {
 #include "logo.embed"
@@ -30,50 +33,99 @@ namespace Atlas {
 		s_Instance = this;
 
 		m_ViewportSize = { info.width, info.height };
+		m_FrameStatsPath = info.frameStatsPath;
+		m_Headless = info.headless;
+		m_FrameCount = info.frameCount;
+		m_FixedTimestep = info.fixedTimestep;
+		m_MaxFixedSteps = info.maxFixedSteps;
 
 		WindowCreateInfo winInfo;
 		winInfo.title = info.title;
 		winInfo.width = info.width;
 		winInfo.height = info.height;
 		winInfo.icon = s_Logo;
+		winInfo.headless = info.headless;
 
 		m_Window = make_scope<Window>(winInfo);
-		m_Window->set_event_callback(BIND_EVENT_FN(Application::on_event));
+		m_Window->set_event_callback(BIND_EVENT_FN(Application::on_window_event));
 
-		Random::init();
+		m_Input = make_scope<RecordedInput>();
+		m_WindowEvents = make_scope<EventQueue>();
+		m_QueuedEvents = make_scope<EventQueue>();
+
+		// a replay starts from the seed of the recording so random initialization matches too
+		if (!info.replayPath.empty()) {
+			m_Replayer = make_scope<EventReplayer>();
+			if (!m_Replayer->open(info.replayPath)) m_Replayer.reset();
+		}
+
+		if (m_Replayer) Random::init(m_Replayer->get_seed());
+		else Random::init();
+
+		if (!info.recordPath.empty()) {
+			m_Recorder = make_scope<EventRecorder>();
+			if (!m_Recorder->open(info.recordPath, Random::get_seed())) m_Recorder.reset();
+		}
+
+		Jobs::init(info.jobWorkers);
 		Render::init();
 
-		m_ImGuiLayer = make_ref<ImGuiLayer>();
-		push_layer(m_ImGuiLayer);
+		// headless runs keep the viewport at the requested size, nothing resizes it
+		if (!m_Headless) {
+			m_ImGuiLayer = make_ref<ImGuiLayer>();
+			push_layer(m_ImGuiLayer);
+		}
+		else {
+			Render::resize_viewport(info.width, info.height);
+		}
 
 		m_ColorBuffer = Texture2D::rgba((uint32_t)m_ViewportSize.x, (uint32_t)m_ViewportSize.y);
 		//m_DepthBuffer = Texture2D::depth((uint32_t)m_ViewportSize.x, (uint32_t)m_ViewportSize.y);
+
+		if (!m_FrameStatsPath.empty()) Profiler::keep_frame_history(true);
 	}
 
 	Application::~Application()
 	{
+		Render::wait_idle();
+
+		if (!m_FrameStatsPath.empty()) Profiler::write_frame_csv(m_FrameStatsPath);
+
 		for (uint32_t i = 0; i < m_LayerStack.size(); i++) {
 			Ref<Layer> layer = m_LayerStack.back();
 			layer->on_detach();
 			m_LayerStack.pop_back();
 		}
 
+		Jobs::shutdown();
+
 		m_Window->destroy();
 	}
 
 	void Application::run()
 	{
+		uint64_t lastFrame = m_FramesRun + m_FrameCount;
+		run_until([this, lastFrame]() { return m_FrameCount && m_FramesRun >= lastFrame; });
+	}
 
+	void Application::run_until(const std::function<bool()> &done)
+	{
 		m_LastFrameTime = (float)m_Window->get_time();
 
-		while (!m_Window->should_close()) {
+		while (!m_Window->should_close() && !done()) {
 			ATL_FRAME("MainThread");
 
 
+			int64_t presentStart = ScopeTimer::now_ns();
 			m_Window->on_update();
+			float presentMs = (float)((ScopeTimer::now_ns() - presentStart) / 1e6);
 			if (m_Window->is_minimized()) continue;
 
+			uint64_t frameIndex = Render::get_frame_index();
+			int64_t cpuStart = ScopeTimer::now_ns();
 			update();
+			Profiler::record_frame(frameIndex, (float)((ScopeTimer::now_ns() - cpuStart) / 1e6), presentMs);
+			m_FramesRun++;
 		}
 	}
 
@@ -81,27 +133,120 @@ namespace Atlas {
 	{
 		ATL_EVENT();
 		Render::frame_start();
-		m_ImGuiLayer->begin();
+		// GL work handed back by jobs of the previous frame
+		Jobs::execute_main_jobs();
+		if (m_ImGuiLayer) m_ImGuiLayer->begin();
+
+		process_window_events();
 
 		float time = (float)m_Window->get_time();
 		Timestep timestep = time - m_LastFrameTime;
 		m_LastFrameTime = time;
 
-		for (Event e : m_QueuedEvents) on_event(e);
-		m_QueuedEvents.clear();
+		if (m_Replayer) {
+			RecordedFrame frame;
+			if (m_Replayer->next_frame(frame)) {
+				timestep = frame.timestep;
+				m_ViewportFocus = frame.input.viewportFocus;
+				m_ViewportHovered = frame.input.viewportHovered;
+				m_ViewportMousePos = frame.input.viewportMouse;
+
+				// the events give the edges, the recorded state stays authoritative
+				for (Event &e : frame.events) Input::on_event(e);
+				Input::set_state(frame.input.keys, frame.input.mouseButtons);
+
+				for (Event &e : frame.events) on_event(e);
+			}
+			else {
+				CORE_INFO("Application: replay finished after {} frames", m_FramesRun);
+				m_Replayer.reset();
+				m_Window->request_close();
+			}
+		}
+
+		Input::new_frame(m_FramesRun, m_ViewportMousePos, m_ViewportFocus, m_ViewportHovered);
+
+		if (m_Recorder && !m_Replayer) {
+			const InputSnapshot &snapshot = Input::get_snapshot();
+			m_Input->keys = snapshot.keys;
+			m_Input->mouseButtons = snapshot.mouseButtons;
+			m_Input->viewportFocus = m_ViewportFocus;
+			m_Input->viewportHovered = m_ViewportHovered;
+			m_Input->viewportMouse = m_ViewportMousePos;
+			m_Recorder->record_frame(timestep, *m_Input);
+		}
+
+		m_QueuedEvents->drain([this](Event &e) { on_event(e); });
+
+		run_fixed_steps(timestep);
 
 		for (auto &layer : m_LayerStack) {
-			layer->on_imgui();
+			if (m_ImGuiLayer) layer->on_imgui();
 			layer->on_update(timestep);
 		}
 		//for (auto &layer : m_LayerStack) layer->on_imgui();
 		//for (auto &layer : m_LayerStack) layer->on_update(timestep);
 
-		render_viewport();
-		m_ImGuiLayer->end();
+		if (m_ImGuiLayer) {
+			render_viewport();
+			m_ImGuiLayer->end();
+		}
 		Render::frame_end();
 	}
 
+	void Application::run_fixed_steps(Timestep timestep)
+	{
+		ATL_EVENT();
+		m_FixedAccumulator += timestep;
+		m_FixedSteps = 0;
+
+		while (m_FixedAccumulator >= m_FixedTimestep && m_FixedSteps < m_MaxFixedSteps) {
+			for (auto &layer : m_LayerStack) layer->on_fixed_update(m_FixedTimestep);
+			m_FixedAccumulator -= m_FixedTimestep;
+			m_FixedSteps++;
+		}
+
+		// a sim that can't keep up falls behind instead of taking ever longer frames to catch up
+		if (m_FixedAccumulator >= m_FixedTimestep) {
+			uint64_t dropped = (uint64_t)(m_FixedAccumulator / m_FixedTimestep);
+			m_DroppedFixedSteps += dropped;
+			m_FixedAccumulator -= dropped * m_FixedTimestep;
+		}
+
+		m_FixedAlpha = m_FixedAccumulator / m_FixedTimestep;
+	}
+
+	void Application::set_fixed_timestep(float seconds)
+	{
+		CORE_ASSERT(seconds > 0, "Application::set_fixed_timestep: timestep has to be positive, it is {}", seconds);
+		get_instance()->m_FixedTimestep = seconds;
+	}
+
+	float Application::get_fixed_timestep()
+	{
+		return get_instance()->m_FixedTimestep;
+	}
+
+	void Application::set_max_fixed_steps(uint32_t steps)
+	{
+		get_instance()->m_MaxFixedSteps = steps;
+	}
+
+	float Application::get_fixed_alpha()
+	{
+		return get_instance()->m_FixedAlpha;
+	}
+
+	uint32_t Application::get_fixed_steps()
+	{
+		return get_instance()->m_FixedSteps;
+	}
+
+	uint64_t Application::get_dropped_fixed_steps()
+	{
+		return get_instance()->m_DroppedFixedSteps;
+	}
+
 	void Application::update_frame()
 	{
 		get_instance()->update();
@@ -129,8 +274,11 @@ namespace Atlas {
 		ImGui::PopStyleColor();
 		ImGui::PopStyleColor();
 
-		m_ViewportFocus = ImGui::IsItemFocused();
-		m_ViewportHovered = ImGui::IsItemHovered();
+		// while replaying the recorded viewport state stays in place
+		if (!m_Replayer) {
+			m_ViewportFocus = ImGui::IsItemFocused();
+			m_ViewportHovered = ImGui::IsItemHovered();
+		}
 
 		ImVec2 windowPosition = ImGui::GetWindowPos();
 		auto [windowRelMousePosX, windowRelMousePosY] = m_Window->get_mouse_pos();
@@ -139,7 +287,7 @@ namespace Atlas {
 		ImVec2 mousePositionAbsolute = { windowRelMousePosX + windowPosX, windowRelMousePosY + windowPosY };
 		ImVec2 screenPositionAbsolute = ImGui::GetItemRectMin();
 		ImVec2 mouseRel = mousePositionAbsolute - screenPositionAbsolute;
-		m_ViewportMousePos = { mouseRel.x, mouseRel.y };
+		if (!m_Replayer) m_ViewportMousePos = { mouseRel.x, mouseRel.y };
 
 		ImGui::EndChild();
 		ImGui::End();
@@ -152,6 +300,21 @@ namespace Atlas {
 		}
 	}
 
+	void Application::close()
+	{
+		get_instance()->m_Window->request_close();
+	}
+
+	bool Application::is_headless()
+	{
+		return get_instance()->m_Headless;
+	}
+
+	uint64_t Application::get_frames_run()
+	{
+		return get_instance()->m_FramesRun;
+	}
+
 	Window &Application::get_window()
 	{
 		return *get_instance()->m_Window.get();
@@ -174,16 +337,17 @@ namespace Atlas {
 		return { pos.first, pos.second };
 	}
 
+	// jobs call these too, focus and key are read from one published snapshot so a publish in between can't mix frames
 	bool Application::is_key_pressed(KeyCode key)
 	{
-		if (!is_viewport_focused()) return false;
-		return get_instance()->m_Window->is_key_pressed(key);
+		const InputSnapshot &snapshot = Input::get_snapshot();
+		return snapshot.viewportFocused && snapshot.is_key_down(key);
 	}
 
 	bool Application::is_mouse_pressed(int button)
 	{
-		if (!is_viewport_focused()) return false;
-		return get_instance()->m_Window->is_mouse_button_pressed(button);
+		const InputSnapshot &snapshot = Input::get_snapshot();
+		return snapshot.viewportFocused && snapshot.is_mouse_down(button);
 	}
 
 	bool Application::is_viewport_focused()
@@ -219,7 +383,7 @@ namespace Atlas {
 
 	void Application::queue_event(Event event)
 	{
-		m_QueuedEvents.push_back(event);
+		if (!m_QueuedEvents->push(event)) CORE_WARN("Application::queue_event: queue is full, dropped {}", event.to_string());
 	}
 
 	glm::vec2 &Application::get_viewport_size()
@@ -227,6 +391,33 @@ namespace Atlas {
 		return get_instance()->m_ViewportSize;
 	}
 
+	void Application::on_window_event(Event &event)
+	{
+		// callbacks run on the main thread, a full queue is dispatched right away instead of dropping input
+		if (m_WindowEvents->push(event)) return;
+		process_window_events();
+		m_WindowEvents->push(event);
+	}
+
+	void Application::process_window_events()
+	{
+		ATL_EVENT();
+		m_WindowEvents->drain([this](Event &e) { handle_window_event(e); });
+	}
+
+	void Application::handle_window_event(Event &event)
+	{
+		// live input would make the replay diverge, closing the window still works
+		if (m_Replayer) {
+			if (event.get_type() == EventType::WindowClosed) on_event(event);
+			return;
+		}
+
+		Input::on_event(event);
+		if (m_Recorder) m_Recorder->record_event(event);
+		on_event(event);
+	}
+
 	void Application::on_event(Event &event)
 	{
 		if (event.in_category(EventCategory::Input) && !m_ViewportHovered) return;
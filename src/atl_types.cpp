@@ -2,6 +2,7 @@
 
 #include "gl_utils.h"
 #include "gl_atl_utils.h"
+#include "RenderApi.h"
 
 #include <stb_image.h>
 
@@ -19,23 +20,60 @@ bool ImGui::ImageButton(const Atlas::Texture2D &texture, const ImVec2 &size, con
 
 namespace Atlas::Random {
 
-	static thread_local std::mt19937 s_RandomEngine;
-	static std::uniform_int_distribution<int64_t> s_IntDistribution;
-	static std::uniform_real_distribution<double> s_RealDistribution;
+	struct ThreadGenerator {
+		Generator generator;
+		uint64_t generation{ 0 };
+	};
+
+	static std::atomic<uint64_t> s_Seed{ 0 };
+	// bumped by every init, threads seeded before pick up the new seed on their next draw
+	static std::atomic<uint64_t> s_Generation{ 1 };
+	static std::atomic<uint64_t> s_NextForeignStream{ 0 };
+	static thread_local ThreadGenerator s_ThreadGenerator;
 
 	void init()
 	{
-		s_RandomEngine.seed(std::random_device()());
+		std::random_device device;
+		init(((uint64_t)device() << 32) | device());
+	}
+
+	void init(uint64_t seed)
+	{
+		s_Seed = seed;
+		s_ThreadGenerator.generator.reseed(seed);
+		s_ThreadGenerator.generation = s_Generation.fetch_add(1) + 1;
+	}
+
+	uint64_t get_seed()
+	{
+		return s_Seed;
+	}
+
+	Generator &get_generator()
+	{
+		auto &thread = s_ThreadGenerator;
+		uint64_t generation = s_Generation.load(std::memory_order_acquire);
+		if (thread.generation != generation) {
+			// the main thread is stream 0 like the thread that called init, threads outside the job system
+			// can't be told apart between runs and only get streams in the order they first draw
+			int worker = Jobs::get_worker_index();
+			uint64_t index = worker >= 0 ? (uint64_t)worker
+				: Jobs::get_thread_count() + s_NextForeignStream.fetch_add(1, std::memory_order_relaxed);
+
+			thread.generator = Generator::stream(s_Seed, index);
+			thread.generation = generation;
+		}
+		return thread.generator;
 	}
 
 	int64_t uniform_integer()
 	{
-		return s_IntDistribution(s_RandomEngine);
+		return (int64_t)get_generator().next();
 	}
 
 	double uniform_real()
 	{
-		return s_RealDistribution(s_RandomEngine);
+		return get_generator().unit();
 	}
 }
 
@@ -54,6 +92,25 @@ namespace Atlas {
 
 	static BindingContext s_GlobalBindingContext;
 
+	// engine kernels behind fill_pattern, compiled the first time they are used
+	static Shader s_FillTextureShader;
+	static Shader s_FillBufferShader;
+
+	static Shader &load_fill_shader(Shader &shader, const char *file)
+	{
+		if (!shader.is_init()) shader = Shader::load_comp(file);
+		return shader;
+	}
+
+	static void complete_on_retire(gl_utils::GLReadback readback, ReadbackCallback callback)
+	{
+		Render::on_frame_retired([readback, callback]() mutable {
+			const void *data = gl_utils::map_readback(&readback);
+			callback(data, readback.size);
+			gl_utils::release_readback(&readback);
+		});
+	}
+
 	inline uint32_t to_rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
 		return (a << 24) | (b << 16) | (g << 8) | r;
 	}
@@ -309,6 +366,77 @@ namespace Atlas {
 		m_Texture->set_data(data, color_format_to_int_gl_enum(m_Format));
 	}
 
+	void Texture2D::clear(RGBA color) const
+	{
+		CORE_ASSERT(m_Texture, "Texture2D::clear: texture was not initialized!");
+		ATL_EVENT();
+
+		if (m_Format != ColorFormat::R8G8B8A8 && m_Format != ColorFormat::R8G8B8) {
+			CORE_WARN("Texture2D::clear: only color textures can be cleared to a color");
+			return;
+		}
+
+		// packed as r, g, b, a bytes in memory
+		uint32_t data = (uint32_t)color;
+		gl_utils::clear_texture2D(m_Texture->id(), GL_RGBA, GL_UNSIGNED_BYTE, &data);
+	}
+
+	void Texture2D::fill_pattern(const TexturePatternInfo &info) const
+	{
+		CORE_ASSERT(m_Texture, "Texture2D::fill_pattern: texture was not initialized!");
+		if (m_Format != ColorFormat::R8G8B8A8) {
+			CORE_WARN("Texture2D::fill_pattern: only R8G8B8A8 textures can be written by the fill kernel");
+			return;
+		}
+		ATL_EVENT();
+
+		Shader &shader = load_fill_shader(s_FillTextureShader, "assets/shaders/fill_texture.comp");
+
+		RGBA from = info.from;
+		RGBA to = info.to;
+		shader.set_uint("pattern", (uint32_t)info.pattern);
+		shader.set_uint("seed", info.seed ? info.seed : Random::get<uint32_t>());
+		shader.set_uint("cellSize", std::max(1u, info.cellSize));
+		shader.set_float4("colorFrom", from.normalized());
+		shader.set_float4("colorTo", to.normalized());
+
+		Shader::bind(shader);
+		Texture2D::bind(*this, 0, TextureUsage::WRITE);
+		Shader::dispatch(shader, (width() + 15) / 16, (height() + 15) / 16, 1);
+
+		// later samples, image loads and readbacks see the pattern
+		memory_barrier(Barrier::ALL);
+	}
+
+	void Texture2D::read_async(const TextureRegion &region, ReadbackCallback callback) const
+	{
+		CORE_ASSERT(m_Texture, "Texture2D::read_async: texture was not initialized!");
+		// a zero width or height means up to the edge, so the origin has to lie inside the texture
+		CORE_ASSERT(region.x < width() && region.y < height(), "Texture2D::read_async: region origin ({}, {}) out of bounds", region.x, region.y);
+		CORE_ASSERT(region.width <= width() - region.x, "Texture2D::read_async: region width {} out of bounds", region.width);
+		CORE_ASSERT(region.height <= height() - region.y, "Texture2D::read_async: region height {} out of bounds", region.height);
+		ATL_EVENT();
+
+		uint32_t regionWidth = region.width ? region.width : width() - region.x;
+		uint32_t regionHeight = region.height ? region.height : height() - region.y;
+		size_t size = (size_t)regionWidth * regionHeight * color_format_to_bytes(m_Format);
+
+		auto readback = gl_utils::read_texture_async(m_Texture->id(), region.x, region.y, regionWidth, regionHeight,
+			color_format_to_int_gl_enum(m_Format), color_format_to_gl_type(m_Format), size);
+		complete_on_retire(readback, callback);
+	}
+
+	std::vector<uint8_t> Texture2D::get_data() const
+	{
+		CORE_ASSERT(m_Texture, "Texture2D::get_data: texture was not initialized!");
+		ATL_EVENT();
+
+		std::vector<uint8_t> data((size_t)width() * height() * color_format_to_bytes(m_Format));
+		gl_utils::read_texture(m_Texture->id(), color_format_to_int_gl_enum(m_Format), color_format_to_gl_type(m_Format), data.data(), data.size());
+
+		return data;
+	}
+
 	//void Texture2D::bind(uint32_t indx) const
 	//{
 	//	m_Texture->bind(indx);
@@ -446,13 +574,15 @@ namespace Atlas {
 	}
 
 	Buffer::Buffer(const BufferCreateInfo &info)
-		: m_Stride(info.stride), m_Types(info.types)
+		: m_Stride(info.stride), m_Types(info.types), m_Usage(info.usage), m_Storage(info.storage)
 	{
 
 		gl_utils::GLBufferCreateInfo buffInfo{};
 		buffInfo.size = info.size;
 		buffInfo.data = info.data;
 		buffInfo.usage = buffer_usage_to_gl_enum(info.usage);
+		buffInfo.immutable = info.storage != 0;
+		buffInfo.storageFlags = buffer_storage_to_gl_flags(info.storage);
 
 		m_Buffer = make_ref<gl_utils::GLBuffer>(buffInfo);
 	}
@@ -506,6 +636,32 @@ namespace Atlas {
 		glUnmapNamedBuffer(buffer.m_Buffer->id());
 	}
 
+	void *Buffer::map_persistent_data() const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::map_persistent: buffer was not initialized!");
+		CORE_ASSERT(m_Storage & BufferStorage::PERSISTENT, "Buffer::map_persistent: buffer was not created with BufferStorage::PERSISTENT");
+		return m_Buffer->map_persistent();
+	}
+
+	void *Buffer::map_range(size_t offset, size_t size, MapAccessBits access) const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::map_range: buffer was not initialized!");
+		CORE_ASSERT(offset + size <= m_Buffer->size(), "Buffer::map_range: range [{}, {}) out of bounds", offset, offset + size);
+		return m_Buffer->map_range(offset, size, map_access_to_gl_flags(access));
+	}
+
+	void Buffer::unmap() const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::unmap: buffer was not initialized!");
+		m_Buffer->unmap();
+	}
+
+	void Buffer::flush_range(size_t offset, size_t size) const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::flush_range: buffer was not initialized!");
+		m_Buffer->flush_range(offset, size);
+	}
+
 	size_t Buffer::hash() const
 	{
 		return std::hash<void *>()(m_Buffer.get());
@@ -547,6 +703,19 @@ namespace Atlas {
 		return Buffer(info);
 	}
 
+	Buffer Buffer::immutable(BufferTypeBits types, const void *data, size_t size, BufferStorageBits storage, size_t stride)
+	{
+		BufferCreateInfo info{};
+		info.size = size;
+		info.data = (void *)data;
+		info.types = types;
+		info.usage = BufferUsage::STATIC;
+		info.stride = stride ? stride : size;
+		info.storage = storage | BufferStorage::IMMUTABLE;
+
+		return Buffer(info);
+	}
+
 	Buffer Buffer::index(size_t count, BufferUsage usage)
 	{
 		BufferCreateInfo info{};
@@ -560,15 +729,63 @@ namespace Atlas {
 	}
 
 	void Buffer::set_data(void *data, size_t size) {
-		CORE_ASSERT(m_Buffer, "Buffer::bind: buffer was not initialized!");
-		CORE_ASSERT(size <= m_Buffer->size(), "Buffer::set_data: size has to be smaller or equal then {}. it is {}", m_Buffer->size(), size);
+		set_data(0, data, size);
+	}
+
+	void Buffer::set_data(size_t offset, const void *data, size_t size) {
+		CORE_ASSERT(m_Buffer, "Buffer::set_data: buffer was not initialized!");
+		CORE_ASSERT(offset + size <= m_Buffer->size(), "Buffer::set_data: range [{}, {}) has to be inside the buffer of size {}", offset, offset + size, m_Buffer->size());
+		ATL_EVENT();
+
+		CORE_ASSERT(!m_Storage || (m_Storage & BufferStorage::DYNAMIC), "Buffer::set_data: immutable buffer was not created with BufferStorage::DYNAMIC");
+
+		if (m_Usage == BufferUsage::STREAM && offset == 0) m_Buffer->invalidate();
+		m_Buffer->set_data(data, offset, size);
+	}
+
+	void Buffer::clear(uint32_t value, size_t offset, size_t size) const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::clear: buffer was not initialized!");
+		if (size == 0) size = m_Buffer->size() - offset;
+		CORE_ASSERT(offset % 4 == 0 && size % 4 == 0 && offset + size <= m_Buffer->size(), "Buffer::clear: range [{}, {}) has to be 4 byte aligned and inside the buffer", offset, offset + size);
 		ATL_EVENT();
-		m_Buffer->set_data(data, size);
+
+		gl_utils::clear_buffer(m_Buffer->id(), offset, size, value);
+	}
+
+	void Buffer::fill_pattern(const BufferPatternInfo &info) const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::fill_pattern: buffer was not initialized!");
+		size_t size = info.size ? info.size : m_Buffer->size() - info.offset;
+		CORE_ASSERT(info.offset % 4 == 0 && size % 4 == 0 && info.offset + size <= m_Buffer->size(), "Buffer::fill_pattern: range [{}, {}) has to be 4 byte aligned and inside the buffer", info.offset, info.offset + size);
+		ATL_EVENT();
+
+		Shader &shader = load_fill_shader(s_FillBufferShader, "assets/shaders/fill_buffer.comp");
+
+		uint32_t count = (uint32_t)(size / 4);
+		shader.set_uint("pattern", (uint32_t)info.pattern);
+		shader.set_uint("seed", info.seed ? info.seed : Random::get<uint32_t>());
+		shader.set_uint("first", (uint32_t)(info.offset / 4));
+		shader.set_uint("count", count);
+		shader.set_float("minValue", info.min);
+		shader.set_float("maxValue", info.max);
+
+		Shader::bind(shader);
+		gl_utils::bind_storage_buffer(m_Buffer, 0);
+
+		// group counts are capped, the kernel strides over the rest
+		uint32_t groups = (uint32_t)std::min<uint64_t>(((uint64_t)count + 255) / 256, 65535);
+		Shader::dispatch(shader, std::max(1u, groups), 1, 1);
+
+		memory_barrier(Barrier::ALL);
 	}
 
-	std::vector<void *> Buffer::get_data()
+	std::vector<uint8_t> Buffer::get_data() const
 	{
-		std::vector<void *> buffer;
+		CORE_ASSERT(m_Buffer, "Buffer::get_data: buffer was not initialized!");
+		ATL_EVENT();
+
+		std::vector<uint8_t> buffer;
 		buffer.resize(m_Buffer->size());
 
 		glGetNamedBufferSubData(m_Buffer->id(), 0, m_Buffer->size(), buffer.data());
@@ -576,12 +793,41 @@ namespace Atlas {
 		return buffer;
 	}
 
+	void Buffer::read_async(size_t offset, size_t size, ReadbackCallback callback) const
+	{
+		CORE_ASSERT(m_Buffer, "Buffer::read_async: buffer was not initialized!");
+		CORE_ASSERT(offset + size <= m_Buffer->size(), "Buffer::read_async: range [{}, {}) out of bounds", offset, offset + size);
+		ATL_EVENT();
+
+		complete_on_retire(gl_utils::read_buffer_async(m_Buffer->id(), offset, size), callback);
+	}
+
 	size_t Buffer::size() const
 	{
 		CORE_ASSERT(m_Buffer, "Buffer::bind: buffer was not initialized!");
 		return m_Buffer->size();
 	}
 
+	Fence Fence::insert()
+	{
+		Fence fence;
+		fence.m_Fence = make_ref<gl_utils::GLFence>();
+		return fence;
+	}
+
+	bool Fence::is_signaled() const
+	{
+		CORE_ASSERT(m_Fence, "Fence::is_signaled: fence was not initialized!");
+		return m_Fence->is_signaled();
+	}
+
+	bool Fence::wait(uint64_t timeoutNs) const
+	{
+		CORE_ASSERT(m_Fence, "Fence::wait: fence was not initialized!");
+		ATL_EVENT();
+		return m_Fence->wait(timeoutNs);
+	}
+
 	VertexLayout VertexLayout::empty()
 	{
 		auto layout = VertexLayout();
@@ -629,8 +875,10 @@ namespace Atlas {
 		if (info.modules.size() == 1 && info.modules.at(0).second == ShaderType::COMPUTE) m_IsCompute = true;
 
 		for (auto &module : info.modules) {
-			shaderInfo.push_back({ module.first, shader_type_to_gl_enum(module.second) });
+			shaderInfo.modules.push_back({ module.first, shader_type_to_gl_enum(module.second) });
 		}
+		shaderInfo.defines = info.defines;
+		shaderInfo.async = info.async;
 
 		m_Shader = make_ref<gl_utils::GLShader>(shaderInfo);
 	}
@@ -658,6 +906,11 @@ namespace Atlas {
 			const Texture2D &tex = pair.second.texture;
 			const TextureUsageBits usages = pair.second.usages;
 
+			if (pair.second.bindingPoint == -1) {
+				CORE_ASSERT(shader.m_Shader->get_uniform_location(pair.first) != -1, "Shader::bind: could not find uniform: {}", pair.first);
+				pair.second.bindingPoint = shader.m_Shader->get_int(pair.first.c_str());
+			}
+
 			Texture2D::bind(tex, pair.second.bindingPoint, usages);
 		}
 
@@ -681,23 +934,31 @@ namespace Atlas {
 		glDispatchCompute(nGroupsX, nGroupsY, nGroupsZ);
 	}
 
-	Shader Shader::load_vert_frag(const std::string &vertexFile, const std::string &fragFile, const VertexLayout &layout)
+	Shader Shader::load_vert_frag(const std::string &vertexFile, const std::string &fragFile, const VertexLayout &layout, bool async)
 	{
 		ShaderCreateInfo info{};
 		info.layout = layout;
+		info.async = async;
 		info.modules.push_back({ vertexFile, ShaderType::VERTEX });
 		info.modules.push_back({ fragFile, ShaderType::FRAGMENT });
 		return Shader(info);
 	}
 
-	Shader Shader::load_comp(const std::string &file)
+	Shader Shader::load_comp(const std::string &file, bool async)
 	{
 		ShaderCreateInfo info{};
 		info.layout = VertexLayout::empty();
+		info.async = async;
 		info.modules.push_back({ file, ShaderType::COMPUTE });
 		return Shader(info);
 	}
 
+	bool Shader::is_ready() const
+	{
+		CORE_ASSERT(is_init(), "Shader::is_ready: Shader was not initialized!");
+		return m_Shader->is_ready();
+	}
+
 	void Shader::set_int(const std::string &name, int32_t value)
 	{
 		m_Shader->set_int(name.c_str(), value);
@@ -787,24 +1048,30 @@ namespace Atlas {
 	{
 		CORE_ASSERT(buffer.m_Types & (BufferType::UNIFORM | BufferType::STORAGE), "Shader::bind: buffer was not initialized as unifrom / storage buffer!");
 
+		// don't wait for a compiling shader just to validate the name
+		bool ready = m_Shader->is_ready();
+
 		if (buffer.m_Types & BufferType::UNIFORM) {
-			if (m_Shader->get_uniform_block_binding(name) == -1) CORE_WARN("Shader::bind: could not find Uniform Buffer: {}", name);
+			if (ready && m_Shader->get_uniform_block_binding(name) == -1) CORE_WARN("Shader::bind: could not find Uniform Buffer: {}", name);
 			m_UniformBuffers.insert_or_assign(name, buffer);
 		}
 		else if (buffer.m_Types & BufferType::STORAGE) {
-			if (m_Shader->get_storage_block_binding(name) == -1) CORE_WARN("Shader::bind: could not find Storage Buffer: {}", name);
+			if (ready && m_Shader->get_storage_block_binding(name) == -1) CORE_WARN("Shader::bind: could not find Storage Buffer: {}", name);
 			m_StorageBuffers.insert_or_assign(name, buffer);
 		}
 	}
 
 	void Shader::bind(const std::string &name, const Texture2D &texture, TextureUsageBits usages)
 	{
-		CORE_ASSERT(m_Shader->get_uniform_location(name) != -1, "Shader::bind: could not find uniform: {}", name);
-
 		BoundTextureInfo info{};
 		info.texture = texture;
 		info.usages = usages;
-		info.bindingPoint = m_Shader->get_int(name.c_str());
+
+		if (m_Shader->is_ready()) {
+			CORE_ASSERT(m_Shader->get_uniform_location(name) != -1, "Shader::bind: could not find uniform: {}", name);
+			info.bindingPoint = m_Shader->get_int(name.c_str());
+		}
+
 		m_Textures.insert_or_assign(name, info);
 	}
 
@@ -829,6 +1096,44 @@ namespace Atlas {
 		return std::hash<void *>()(m_Shader.get());
 	}
 
+	ShaderVariantCache::ShaderVariantCache(const ShaderCreateInfo &info)
+		: m_Info(info)
+	{
+	}
+
+	ShaderVariantCache ShaderVariantCache::vert_frag(const std::string &vertexFile, const std::string &fragFile, const VertexLayout &layout, bool async)
+	{
+		ShaderCreateInfo info{};
+		info.layout = layout;
+		info.async = async;
+		info.modules.push_back({ vertexFile, ShaderType::VERTEX });
+		info.modules.push_back({ fragFile, ShaderType::FRAGMENT });
+		return ShaderVariantCache(info);
+	}
+
+	ShaderVariantCache ShaderVariantCache::comp(const std::string &file, bool async)
+	{
+		ShaderCreateInfo info{};
+		info.layout = VertexLayout::empty();
+		info.async = async;
+		info.modules.push_back({ file, ShaderType::COMPUTE });
+		return ShaderVariantCache(info);
+	}
+
+	Shader &ShaderVariantCache::get(const ShaderDefines &defines)
+	{
+		CORE_ASSERT(is_init(), "ShaderVariantCache::get: cache was not initialized!");
+
+		auto it = m_Variants.find(defines);
+		if (it != m_Variants.end()) return it->second;
+
+		ATL_EVENT();
+		ShaderCreateInfo info = m_Info;
+		for (auto &define : defines) info.defines.insert_or_assign(define.first, define.second);
+
+		return m_Variants.insert({ defines, Shader(info) }).first->second;
+	}
+
 	bool operator==(const Texture2D &t1, const Texture2D &t2)
 	{
 		return t1.m_Texture == t2.m_Texture;
@@ -0,0 +1,413 @@
+#include "bench.h"
+
+#include "RenderApi.h"
+#include "Render2D.h"
+#include "Profiler.h"
+#include "physarum.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace Atlas;
+
+// resources of the scene that is running, released by its teardown
+struct BenchData {
+	std::vector<Texture2D> textures;
+	Texture2D boardIn;
+	Texture2D boardOut;
+	Texture2D trailMap;
+
+	Buffer agentPositions;
+	Buffer agentStates;
+	Buffer simBuffer;
+	Buffer blurBuffer;
+	Buffer summedArea;
+	int agentCount = 0;
+	bool useSummedArea = false;
+
+	Shader golShader;
+	ShaderVariantCache agentShaders;
+	ShaderVariantCache blurShaders;
+	Shader summedAreaShader;
+	ShaderDefines agentDefines;
+	ShaderDefines blurDefines;
+};
+
+static BenchData s_BenchData;
+
+static void begin_2d()
+{
+	Render2D::set_view_proj(glm::ortho(0.0f, 1.0f, 0.0f, 1.0f));
+	Render::begin(Application::get_viewport_color());
+}
+
+static void end_2d()
+{
+	Render2D::flush();
+	Render::end();
+}
+
+static void release_bench_data()
+{
+	s_BenchData = BenchData{};
+}
+
+static std::string count_name(uint64_t count)
+{
+	if (count >= 1000000 && count % 1000000 == 0) return std::to_string(count / 1000000) + "M";
+	if (count >= 1000 && count % 1000 == 0) return std::to_string(count / 1000) + "k";
+	return std::to_string(count);
+}
+
+static BenchScene quad_scene(uint32_t count)
+{
+	BenchScene scene{};
+	scene.name = "quads_" + count_name(count);
+	scene.quadsPerFrame = count;
+	scene.setup = []() {};
+	scene.frame = [count]() {
+		uint32_t side = (uint32_t)std::ceil(std::sqrt((double)count));
+		float size = 1.0f / side;
+
+		begin_2d();
+		for (uint32_t i = 0; i < count; i++) {
+			glm::vec2 pos((i % side) * size, (i / side) * size);
+			Render2D::rect(pos, { size, size }, RGBA((uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16)));
+		}
+		end_2d();
+	};
+	scene.teardown = release_bench_data;
+	return scene;
+}
+
+// more textures than Render2D has slots, every few quads force a flush
+static BenchScene texture_thrash_scene(uint32_t count, uint32_t textureCount)
+{
+	BenchScene scene{};
+	scene.name = "texture_thrash_" + count_name(count) + "_" + std::to_string(textureCount);
+	scene.quadsPerFrame = count;
+	scene.setup = [textureCount]() {
+		for (uint32_t i = 0; i < textureCount; i++) {
+			Texture2D texture = Texture2D::rgba(4, 4, TextureFilter::NEAREST);
+			texture.fill(RGBA(Random::get<uint8_t>(), Random::get<uint8_t>(), Random::get<uint8_t>()));
+			s_BenchData.textures.push_back(texture);
+		}
+	};
+	scene.frame = [count]() {
+		uint32_t side = (uint32_t)std::ceil(std::sqrt((double)count));
+		float size = 1.0f / side;
+		auto &textures = s_BenchData.textures;
+
+		begin_2d();
+		for (uint32_t i = 0; i < count; i++) {
+			glm::vec2 pos((i % side) * size, (i / side) * size);
+			Render2D::rect(pos, { size, size }, textures.at(i % textures.size()));
+		}
+		end_2d();
+	};
+	scene.teardown = release_bench_data;
+	return scene;
+}
+
+// few large overlapping circles, bound by fragment shading
+static BenchScene circle_scene(uint32_t count, float radius)
+{
+	BenchScene scene{};
+	scene.name = "circles_" + count_name(count);
+	scene.quadsPerFrame = count;
+	scene.setup = []() {};
+	scene.frame = [count, radius]() {
+		begin_2d();
+		for (uint32_t i = 0; i < count; i++) {
+			// deterministic spread so every run draws the same picture
+			glm::vec2 center((i * 0.618034f) - std::floor(i * 0.618034f), (i * 0.414214f) - std::floor(i * 0.414214f));
+			Render2D::circle(center, radius, RGBA(255, (uint8_t)i, 128, 32));
+		}
+		end_2d();
+	};
+	scene.teardown = release_bench_data;
+	return scene;
+}
+
+// a sensor size of 0 keeps the default settings
+static BenchScene agents_scene(int count, int imgSize, float sensorSize = 0)
+{
+	bool useSummedArea = int(sensorSize / 2) >= SUMMED_AREA_MIN_SIZE;
+
+	BenchScene scene{};
+	scene.name = "agents_" + count_name(count);
+	if (sensorSize > 0) scene.name += "_sensor" + std::to_string((int)sensorSize);
+	scene.dispatchesPerFrame = useSummedArea ? 4 : 2;
+	scene.setup = [count, imgSize, sensorSize, useSummedArea]() {
+		GlobalSettings settings{};
+		default_settings(settings);
+		if (sensorSize > 0) settings.sim.sensorSize = sensorSize;
+
+		s_BenchData.agentCount = count;
+		s_BenchData.trailMap = Texture2D::rgba(imgSize, imgSize, TextureFilter::NEAREST);
+		Agents agents = spawn_agents(count, imgSize, 3);
+		s_BenchData.agentPositions = Buffer::create(BufferType::STORAGE, agents.positions.data(), count * sizeof(glm::vec2));
+		s_BenchData.agentStates = Buffer::create(BufferType::STORAGE, agents.states.data(), count * sizeof(uint32_t));
+		s_BenchData.simBuffer = Buffer::storage(settings.sim);
+		s_BenchData.blurBuffer = Buffer::storage(settings.blur);
+
+		// same variants the simulation picks for its default settings
+		s_BenchData.agentShaders = agent_shader_variants();
+		s_BenchData.blurShaders = ShaderVariantCache::comp("assets/shaders/blur.comp");
+		s_BenchData.agentDefines = { { "SENSOR_SIZE", std::to_string(int(settings.sim.sensorSize / 2)) } };
+		s_BenchData.blurDefines = { { "KERNEL_SIZE", std::to_string(settings.blur.kernelSize) } };
+
+		s_BenchData.useSummedArea = useSummedArea;
+		if (useSummedArea) s_BenchData.summedAreaShader = Shader::load_comp("assets/shaders/summed_area.comp");
+	};
+	scene.frame = []() {
+		auto &data = s_BenchData;
+		Shader &agentShader = data.agentShaders.get(data.agentDefines);
+		Shader &blurShader = data.blurShaders.get(data.blurDefines);
+
+		agentShader.bind("AgentPositions", data.agentPositions);
+		agentShader.bind("AgentStates", data.agentStates);
+		agentShader.bind("outImg", data.trailMap, TextureUsage::WRITE);
+		agentShader.bind("settingsBuffer", data.simBuffer);
+
+		if (data.useSummedArea) {
+			ATL_GPU_EVENT("summed area");
+			build_summed_area(data.summedAreaShader, data.trailMap, data.summedArea);
+			agentShader.bind("SummedArea", data.summedArea);
+		}
+
+		blurShader.bind("img", data.trailMap, TextureUsage::READ | TextureUsage::WRITE);
+		blurShader.bind("settingsBuffer", data.blurBuffer);
+
+		{
+			ATL_GPU_EVENT("agents");
+			Shader::dispatch(agentShader, (data.agentCount + 1023) / 1024, 1, 1);
+		}
+		{
+			ATL_GPU_EVENT("blur");
+			Shader::dispatch(blurShader, (data.trailMap.width() + 31) / 32, data.trailMap.height() / 32, 1);
+		}
+	};
+	scene.teardown = release_bench_data;
+	return scene;
+}
+
+static BenchScene game_of_life_scene(uint32_t size)
+{
+	BenchScene scene{};
+	scene.name = "game_of_life_" + std::to_string(size / 1024) + "K";
+	scene.dispatchesPerFrame = 1;
+	scene.setup = [size]() {
+		TexturePatternInfo board{};
+		board.pattern = TexturePattern::RANDOM_GRAY;
+
+		s_BenchData.boardIn = Texture2D::rgba(size, size, TextureFilter::NEAREST);
+		s_BenchData.boardIn.fill_pattern(board);
+		s_BenchData.boardOut = Texture2D::rgba(size, size, TextureFilter::NEAREST);
+		s_BenchData.golShader = Shader::load_comp("assets/shaders/game_of_life.comp");
+	};
+	scene.frame = []() {
+		auto &data = s_BenchData;
+		data.golShader.bind("inputBoard", data.boardIn, TextureUsage::READ);
+		data.golShader.bind("outputBoard", data.boardOut, TextureUsage::WRITE);
+		{
+			ATL_GPU_EVENT("game of life");
+			Shader::dispatch(data.golShader, data.boardIn.width() / 32, data.boardIn.height() / 32, 1);
+		}
+		memory_barrier(Barrier::IMAGE_ACCESS);
+
+		std::swap(data.boardIn, data.boardOut);
+	};
+	scene.teardown = release_bench_data;
+	return scene;
+}
+
+BenchLayer::BenchLayer(const BenchOptions &options)
+	: m_Options(options)
+{
+}
+
+void BenchLayer::add_scenes()
+{
+	for (uint32_t count : { 10000, 100000, 1000000 }) m_Scenes.push_back(quad_scene(count));
+	m_Scenes.push_back(texture_thrash_scene(100000, 64));
+	m_Scenes.push_back(circle_scene(1000, 0.25f));
+	for (int count : { 50000, 250000, 1000000, 4000000, 10000000 }) m_Scenes.push_back(agents_scene(count, 1024));
+	for (float sensorSize : { 4.f, 8.f, 16.f }) m_Scenes.push_back(agents_scene(1000000, 1024, sensorSize));
+	for (uint32_t size : { 1024, 2048, 4096, 8192, 16384 }) m_Scenes.push_back(game_of_life_scene(size));
+
+	if (!m_Options.filter.empty()) {
+		m_Scenes.erase(std::remove_if(m_Scenes.begin(), m_Scenes.end(), [&](const BenchScene &scene) {
+			return scene.name.find(m_Options.filter) == std::string::npos;
+		}), m_Scenes.end());
+	}
+}
+
+// reads a number following "key": in a line written by write_result
+static float find_number(const std::string &line, const std::string &key)
+{
+	size_t pos = line.find("\"" + key + "\":");
+	if (pos == std::string::npos) return -1;
+	return std::stof(line.substr(pos + key.size() + 3));
+}
+
+void BenchLayer::on_attach()
+{
+	Render2D::init();
+	Application::set_vsync(false);
+
+	add_scenes();
+
+	// the medians come from the frame statistics ring
+	if (m_Options.frames > Profiler::FRAME_RING_SIZE) {
+		CORE_WARN("BenchLayer: only the last {} of {} frames per scene are timed", Profiler::FRAME_RING_SIZE, m_Options.frames);
+	}
+
+	if (!m_Options.outputPath.empty()) {
+		m_Output.open(m_Options.outputPath);
+		if (!m_Output.is_open()) CORE_WARN("BenchLayer: could not open {}", m_Options.outputPath);
+	}
+
+	if (!m_Options.baselinePath.empty()) {
+		std::ifstream baseline(m_Options.baselinePath);
+		if (!baseline.is_open()) CORE_WARN("BenchLayer: could not open baseline {}", m_Options.baselinePath);
+
+		std::string line;
+		while (std::getline(baseline, line)) {
+			size_t start = line.find("\"scene\":\"");
+			if (start == std::string::npos) continue;
+			start += 9;
+			std::string scene = line.substr(start, line.find('"', start) - start);
+			m_Baseline[scene] = { find_number(line, "frame_ms"), find_number(line, "gpu_ms") };
+		}
+	}
+
+	CORE_INFO("BenchLayer: running {} scenes, {} frames each", m_Scenes.size(), m_Options.frames);
+}
+
+void BenchLayer::on_update(Atlas::Timestep ts)
+{
+	if (m_SceneIndex >= m_Scenes.size()) {
+		Application::close();
+		return;
+	}
+
+	BenchScene &scene = m_Scenes.at(m_SceneIndex);
+
+	if (m_Phase == Phase::SETUP) {
+		ATL_EVENT("bench setup");
+		scene.setup();
+		m_Phase = Phase::WARMUP;
+		m_PhaseFrame = 0;
+	}
+
+	if (m_Phase == Phase::WARMUP && m_PhaseFrame == m_Options.warmupFrames) {
+		// nothing of the warmup may still run on the GPU when the clock starts
+		Render::wait_idle();
+		m_Phase = Phase::MEASURE;
+		m_PhaseFrame = 0;
+		m_DrawCalls = 0;
+		m_StartFrame = Render::get_frame_index();
+		m_StartNs = ScopeTimer::now_ns();
+	}
+
+	if (m_Phase == Phase::MEASURE && m_PhaseFrame == m_Options.frames) {
+		finish_scene(scene);
+		return;
+	}
+
+	Render2D::reset_stats();
+	scene.frame();
+	m_DrawCalls += Render2D::get_stats().drawCalls;
+	m_PhaseFrame++;
+}
+
+void BenchLayer::finish_scene(BenchScene &scene)
+{
+	// also resolves the GPU timings of every measured frame
+	Render::wait_idle();
+	int64_t elapsedNs = ScopeTimer::now_ns() - m_StartNs;
+	uint64_t endFrame = Render::get_frame_index();
+
+	std::vector<float> cpu, gpu;
+	for (auto &record : Profiler::get_frame_records()) {
+		if (record.frameIndex < m_StartFrame || record.frameIndex >= endFrame) continue;
+		cpu.push_back(record.cpuMs);
+		if (record.gpuMs >= 0) gpu.push_back(record.gpuMs);
+	}
+
+	auto median = [](std::vector<float> &values) {
+		if (values.empty()) return -1.0f;
+		std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+		return values.at(values.size() / 2);
+	};
+
+	double seconds = elapsedNs / 1e9;
+
+	BenchResult result{};
+	result.scene = scene.name;
+	result.frames = m_Options.frames;
+	result.cpuMs = std::max(median(cpu), 0.0f);
+	result.gpuMs = median(gpu);
+	result.frameMs = (float)(seconds * 1000.0 / m_Options.frames);
+	result.quadsPerSec = scene.quadsPerFrame * m_Options.frames / seconds;
+	result.dispatchesPerSec = scene.dispatchesPerFrame * m_Options.frames / seconds;
+	result.drawCalls = (uint32_t)(m_DrawCalls / m_Options.frames);
+
+	compare_with_baseline(result);
+	write_result(result);
+	m_Results.push_back(result);
+
+	scene.teardown();
+	m_SceneIndex++;
+	m_Phase = Phase::SETUP;
+}
+
+void BenchLayer::compare_with_baseline(BenchResult &result)
+{
+	auto it = m_Baseline.find(result.scene);
+	if (it == m_Baseline.end()) return;
+
+	result.baselineFrameMs = it->second.first;
+	result.baselineGpuMs = it->second.second;
+
+	float limit = 1.0f + m_Options.tolerance;
+	bool frameRegressed = result.baselineFrameMs > 0 && result.frameMs > result.baselineFrameMs * limit;
+	bool gpuRegressed = result.baselineGpuMs > 0 && result.gpuMs > result.baselineGpuMs * limit;
+	result.regression = frameRegressed || gpuRegressed;
+
+	if (result.regression) {
+		CORE_WARN("BenchLayer: {} regressed, {:.3f} ms per frame (baseline {:.3f}), {:.3f} GPU ms (baseline {:.3f})",
+			result.scene, result.frameMs, result.baselineFrameMs, result.gpuMs, result.baselineGpuMs);
+	}
+}
+
+void BenchLayer::write_result(const BenchResult &result)
+{
+	std::stringstream ss;
+	ss << "{\"scene\":\"" << result.scene << "\""
+		<< ",\"frames\":" << result.frames
+		<< ",\"cpu_ms\":" << result.cpuMs
+		<< ",\"gpu_ms\":" << result.gpuMs
+		<< ",\"frame_ms\":" << result.frameMs
+		<< ",\"quads_per_sec\":" << result.quadsPerSec
+		<< ",\"dispatches_per_sec\":" << result.dispatchesPerSec
+		<< ",\"draw_calls\":" << result.drawCalls;
+
+	if (result.baselineFrameMs >= 0) {
+		ss << ",\"baseline_frame_ms\":" << result.baselineFrameMs
+			<< ",\"baseline_gpu_ms\":" << result.baselineGpuMs
+			<< ",\"regression\":" << (result.regression ? "true" : "false");
+	}
+	ss << "}";
+
+	std::cout << ss.str() << std::endl;
+	if (m_Output.is_open()) m_Output << ss.str() << std::endl;
+}
+
+bool BenchLayer::has_regressions() const
+{
+	for (auto &result : m_Results) {
+		if (result.regression) return true;
+	}
+	return false;
+}
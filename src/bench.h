@@ -0,0 +1,74 @@
+#pragma once
+
+#include "application.h"
+
+struct BenchOptions {
+	uint32_t frames = 300;
+	uint32_t warmupFrames = 30;
+	// only scenes whose name contains this run
+	std::string filter;
+	// results go to stdout as json, one scene per line, and to this file if set
+	std::string outputPath;
+	// output of an earlier run, scenes slower by more than tolerance are flagged
+	std::string baselinePath;
+	float tolerance = 0.1f;
+};
+
+struct BenchResult {
+	std::string scene;
+	uint32_t frames = 0;
+	float cpuMs = 0;		// median of the measured frames
+	float gpuMs = -1;		// median, negative without GPU timings
+	float frameMs = 0;		// wall time per frame including the wait for the GPU
+	double quadsPerSec = 0;
+	double dispatchesPerSec = 0;
+	uint32_t drawCalls = 0;
+
+	float baselineFrameMs = -1;
+	float baselineGpuMs = -1;
+	bool regression = false;
+};
+
+struct BenchScene {
+	std::string name;
+	uint64_t quadsPerFrame = 0;
+	uint64_t dispatchesPerFrame = 0;
+
+	std::function<void()> setup;
+	// records the work of one frame
+	std::function<void()> frame;
+	std::function<void()> teardown;
+};
+
+// runs every scene for a fixed number of frames with vsync off and closes the application when done
+class BenchLayer : public Atlas::Layer {
+public:
+	BenchLayer(const BenchOptions &options);
+
+	void on_attach() override;
+	void on_update(Atlas::Timestep ts) override;
+
+	inline const std::vector<BenchResult> &get_results() const { return m_Results; }
+	bool has_regressions() const;
+
+private:
+	enum class Phase { SETUP, WARMUP, MEASURE };
+
+	void add_scenes();
+	void finish_scene(BenchScene &scene);
+	void compare_with_baseline(BenchResult &result);
+	void write_result(const BenchResult &result);
+
+	BenchOptions m_Options;
+	std::vector<BenchScene> m_Scenes;
+	std::vector<BenchResult> m_Results;
+	std::map<std::string, std::pair<float, float>> m_Baseline;
+	std::ofstream m_Output;
+
+	size_t m_SceneIndex{ 0 };
+	Phase m_Phase{ Phase::SETUP };
+	uint32_t m_PhaseFrame{ 0 };
+	uint64_t m_StartFrame{ 0 };
+	int64_t m_StartNs{ 0 };
+	uint64_t m_DrawCalls{ 0 };
+};
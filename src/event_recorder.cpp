@@ -0,0 +1,182 @@
+#include "event_recorder.h"
+
+namespace Atlas {
+
+	static constexpr char LOG_MAGIC[4] = { 'A', 'T', 'L', 'R' };
+	static constexpr uint32_t LOG_VERSION = 2;
+
+	namespace FrameFlags {
+		enum _ : uint8_t {
+			VIEWPORT_FOCUS = 1 << 0,
+			VIEWPORT_HOVERED = 1 << 1,
+			BUTTONS_CHANGED = 1 << 2,
+			MOUSE_CHANGED = 1 << 3,
+		};
+	}
+
+	// the log is written and read on the same kind of machine, values are stored in native byte order
+	template<typename T>
+	static void write_pod(std::ofstream &file, const T &value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be written raw");
+		file.write((const char *)&value, sizeof(T));
+	}
+
+	template<typename T>
+	static bool read_pod(std::ifstream &file, T &value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be read raw");
+		file.read((char *)&value, sizeof(T));
+		return (bool)file;
+	}
+
+	// the key bitset as 64 bytes, a word at a time
+	static void write_keys(std::ofstream &file, const std::bitset<512> &keys)
+	{
+		for (uint32_t word = 0; word < 8; word++) {
+			uint64_t bits = 0;
+			for (uint32_t i = 0; i < 64; i++) bits |= (uint64_t)keys.test(word * 64 + i) << i;
+			write_pod(file, bits);
+		}
+	}
+
+	static bool read_keys(std::ifstream &file, std::bitset<512> &keys)
+	{
+		for (uint32_t word = 0; word < 8; word++) {
+			uint64_t bits = 0;
+			if (!read_pod(file, bits)) return false;
+			for (uint32_t i = 0; i < 64; i++) keys.set(word * 64 + i, (bits >> i) & 1);
+		}
+		return true;
+	}
+
+	bool EventRecorder::open(const std::string &path, uint64_t seed)
+	{
+		m_File.open(path, std::ios::binary | std::ios::trunc);
+		if (!m_File.is_open()) {
+			CORE_WARN("EventRecorder: could not open {}", path);
+			return false;
+		}
+
+		m_File.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+		write_pod(m_File, LOG_VERSION);
+		write_pod(m_File, seed);
+
+		CORE_INFO("EventRecorder: recording to {}", path);
+		return true;
+	}
+
+	void EventRecorder::close()
+	{
+		m_File.close();
+	}
+
+	void EventRecorder::record_event(const Event &event)
+	{
+		if (!is_open()) return;
+		m_Events.push_back(event);
+	}
+
+	void EventRecorder::record_frame(float timestep, const RecordedInput &input)
+	{
+		if (!is_open()) return;
+
+		uint8_t flags = 0;
+		if (input.viewportFocus) flags |= FrameFlags::VIEWPORT_FOCUS;
+		if (input.viewportHovered) flags |= FrameFlags::VIEWPORT_HOVERED;
+
+		bool buttonsChanged = m_FirstFrame || input.keys != m_LastInput.keys || input.mouseButtons != m_LastInput.mouseButtons;
+		bool mouseChanged = m_FirstFrame || input.viewportMouse != m_LastInput.viewportMouse;
+		if (buttonsChanged) flags |= FrameFlags::BUTTONS_CHANGED;
+		if (mouseChanged) flags |= FrameFlags::MOUSE_CHANGED;
+
+		write_pod(m_File, timestep);
+		write_pod(m_File, flags);
+
+		if (buttonsChanged) {
+			write_keys(m_File, input.keys);
+			write_pod(m_File, input.mouseButtons);
+		}
+		if (mouseChanged) write_pod(m_File, input.viewportMouse);
+
+		write_pod(m_File, (uint32_t)m_Events.size());
+		for (auto &event : m_Events) {
+			EventType type = event.get_type();
+			write_pod(m_File, (uint8_t)type);
+
+			switch (type) {
+#define A(x) case EventType::x: write_pod(m_File, event.get<x##Event>()); break;
+				EVENT_LIST
+#undef A
+			default: break;
+			}
+		}
+
+		m_Events.clear();
+		m_LastInput = input;
+		m_FirstFrame = false;
+	}
+
+	bool EventReplayer::open(const std::string &path)
+	{
+		m_File.open(path, std::ios::binary);
+		if (!m_File.is_open()) {
+			CORE_WARN("EventReplayer: could not open {}", path);
+			return false;
+		}
+
+		char magic[4]{};
+		uint32_t version = 0;
+		m_File.read(magic, sizeof(magic));
+		read_pod(m_File, version);
+		read_pod(m_File, m_Seed);
+
+		if (!m_File || std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0 || version != LOG_VERSION) {
+			CORE_WARN("EventReplayer: {} is not an event log of version {}", path, LOG_VERSION);
+			m_File.close();
+			return false;
+		}
+
+		CORE_INFO("EventReplayer: replaying {}", path);
+		return true;
+	}
+
+	bool EventReplayer::next_frame(RecordedFrame &frame)
+	{
+		if (!is_open()) return false;
+
+		uint8_t flags = 0;
+		if (!read_pod(m_File, frame.timestep) || !read_pod(m_File, flags)) return false;
+
+		if (flags & FrameFlags::BUTTONS_CHANGED) {
+			if (!read_keys(m_File, m_Input.keys) || !read_pod(m_File, m_Input.mouseButtons)) return false;
+		}
+		if (flags & FrameFlags::MOUSE_CHANGED) {
+			if (!read_pod(m_File, m_Input.viewportMouse)) return false;
+		}
+
+		m_Input.viewportFocus = flags & FrameFlags::VIEWPORT_FOCUS;
+		m_Input.viewportHovered = flags & FrameFlags::VIEWPORT_HOVERED;
+		frame.input = m_Input;
+
+		uint32_t eventCount = 0;
+		if (!read_pod(m_File, eventCount)) return false;
+
+		frame.events.clear();
+		for (uint32_t i = 0; i < eventCount; i++) {
+			uint8_t type = 0;
+			if (!read_pod(m_File, type)) return false;
+
+			switch ((EventType)type) {
+#define A(x) case EventType::x: { x##Event event{}; if (!read_pod(m_File, event)) return false; frame.events.push_back(Event(event)); break; }
+				EVENT_LIST
+#undef A
+			default:
+				CORE_WARN("EventReplayer: unknown event type {}", type);
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
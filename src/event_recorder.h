@@ -0,0 +1,58 @@
+#pragma once
+
+#include "event.h"
+
+#include <bitset>
+#include <glm/glm.hpp>
+
+namespace Atlas {
+
+	// what layers can query during a frame besides events, recorded so a replay answers the same way
+	struct RecordedInput {
+		std::bitset<512> keys;
+		uint8_t mouseButtons = 0;
+
+		bool viewportFocus = false;
+		bool viewportHovered = false;
+		glm::vec2 viewportMouse{ 0.0f };
+	};
+
+	struct RecordedFrame {
+		float timestep = 0;
+		RecordedInput input;
+		std::vector<Event> events;
+	};
+
+	// binary log: a header with the random seed, then per frame the timestep, the input when it changed and the events
+	class EventRecorder {
+	public:
+		bool open(const std::string &path, uint64_t seed);
+		void close();
+		inline bool is_open() const { return m_File.is_open(); }
+
+		// events arrive between frames and are written with the next frame
+		void record_event(const Event &event);
+		void record_frame(float timestep, const RecordedInput &input);
+
+	private:
+		std::ofstream m_File;
+		std::vector<Event> m_Events;
+		RecordedInput m_LastInput;
+		bool m_FirstFrame{ true };
+	};
+
+	class EventReplayer {
+	public:
+		bool open(const std::string &path);
+		inline bool is_open() const { return m_File.is_open(); }
+		inline uint64_t get_seed() const { return m_Seed; }
+
+		// false once the log ran out
+		bool next_frame(RecordedFrame &frame);
+
+	private:
+		std::ifstream m_File;
+		uint64_t m_Seed{ 0 };
+		RecordedInput m_Input;
+	};
+}
@@ -5,15 +5,12 @@
 #include "camera.h"
 #include "atl_types.h"
 #include "RenderApi.h"
+#include "Profiler.h"
 
 void fill_random(Atlas::Texture2D &tex) {
-	std::vector<Atlas::RGBA> arr(tex.width() * tex.height());
-
-	for (uint32_t i = 0; i < arr.size(); i++) {
-		arr.at(i) = Atlas::RGBA(Atlas::Random::get<uint8_t>());
-	}
-
-	tex.fill(arr.data(), arr.size() * sizeof(Atlas::RGBA));
+	Atlas::TexturePatternInfo info{};
+	info.pattern = Atlas::TexturePattern::RANDOM_GRAY;
+	tex.fill_pattern(info);
 }
 
 class Sandbox : public Atlas::Layer {
@@ -25,6 +22,9 @@ class Sandbox : public Atlas::Layer {
 
 	int size = 1024;
 
+	int population = 0;
+	bool populationPending = false;
+
 	void on_attach() override {
 		using namespace Atlas;
 		Render2D::init();
@@ -46,26 +46,48 @@ class Sandbox : public Atlas::Layer {
 	void on_detach() override {
 	}
 
-	void on_update(Atlas::Timestep ts) override {
+	// one generation per tick, the frame rate only decides how many are shown
+	void on_fixed_update(Atlas::Timestep ts) override {
 		using namespace Atlas;
-		ATL_EVENT("layer update");
-
-		controller.on_update(ts);
-		Render2D::set_camera(controller.get_camera());
+		ATL_EVENT("layer fixed update");
 
 		computeShader.bind("inputBoard", compIn, TextureUsage::READ);
 		computeShader.bind("outputBoard", compOut, TextureUsage::WRITE);
-		Shader::dispatch(computeShader, compIn.width() / 32, compIn.height() / 32, 1);
+		{
+			ATL_GPU_EVENT("game of life");
+			Shader::dispatch(computeShader, compIn.width() / 32, compIn.height() / 32, 1);
+		}
 
 		memory_barrier(Barrier::IMAGE_ACCESS);
 
+		// counted on the CPU a frame or two later, only one readback in flight
+		if (!populationPending) {
+			populationPending = true;
+			compOut.read_async([this](const void *data, size_t size) {
+				const uint8_t *pixels = (const uint8_t *)data;
+				int count = 0;
+				for (size_t i = 0; i < size; i += 4) count += pixels[i] > 127;
+				population = count;
+				populationPending = false;
+			});
+		}
+
+		std::swap(compIn, compOut);
+	}
+
+	void on_update(Atlas::Timestep ts) override {
+		using namespace Atlas;
+		ATL_EVENT("layer update");
+
+		controller.on_update(ts);
+		Render2D::set_camera(controller.get_camera());
+
+		// the newest generation, swapped into compIn by the last step
 		Render::begin(Application::get_viewport_color());
-		Render2D::square({ 0, 0 }, 1, compOut);
+		Render2D::square({ 0, 0 }, 1, compIn);
 
 		Render2D::flush();
 		Render::end();
-
-		std::swap(compIn, compOut);
 	}
 
 	void on_imgui() override {
@@ -74,6 +96,7 @@ class Sandbox : public Atlas::Layer {
 		ImGui::Begin("Settings");
 
 		ImGui::InputInt("size", &size);
+		ImGui::Text("population: %d", population);
 
 		if (ImGui::Button("reload texture")) {
 			compIn = Texture2D::rgba(size, size, Atlas::TextureFilter::NEAREST);
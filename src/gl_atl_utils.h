@@ -8,12 +8,25 @@ GLenum color_format_to_int_gl_enum(const Atlas::ColorFormat format) {
 	case Atlas::ColorFormat::R8G8B8: return GL_RGB;
 	case Atlas::ColorFormat::R8G8B8A8: return GL_RGBA;
 	case Atlas::ColorFormat::D32: return GL_DEPTH_COMPONENT;
+	case Atlas::ColorFormat::D24S8: return GL_DEPTH_STENCIL;
 	}
 
 	CORE_ASSERT(false, "color_format_to_gl_enum: color format {} not defined", (uint32_t)format);
 	return 0;
 }
 
+GLenum color_format_to_gl_type(const Atlas::ColorFormat format) {
+	switch (format) {
+	case Atlas::ColorFormat::R8G8B8:
+	case Atlas::ColorFormat::R8G8B8A8: return GL_UNSIGNED_BYTE;
+	case Atlas::ColorFormat::D32: return GL_FLOAT;
+	case Atlas::ColorFormat::D24S8: return GL_UNSIGNED_INT_24_8;
+	}
+
+	CORE_ASSERT(false, "color_format_to_gl_type: color format {} not defined", (uint32_t)format);
+	return 0;
+}
+
 GLenum color_format_to_gl_enum(const Atlas::ColorFormat format) {
 	switch (format) {
 	case Atlas::ColorFormat::R8G8B8: return GL_RGB8;
@@ -92,12 +105,34 @@ GLenum buffer_usage_to_gl_enum(const Atlas::BufferUsage usage) {
 	{
 	case Atlas::BufferUsage::STATIC: return GL_STATIC_DRAW;
 	case Atlas::BufferUsage::DYNAMIC: return GL_DYNAMIC_DRAW;
+	case Atlas::BufferUsage::STREAM: return GL_STREAM_DRAW;
 	}
 
 	CORE_ASSERT(false, "buffer_usage_to_gl_enum: texture format {} not defined", (uint32_t)usage);
 	return 0;
 }
 
+GLbitfield buffer_storage_to_gl_flags(const Atlas::BufferStorageBits storage) {
+	GLbitfield flags = 0;
+	if (storage & Atlas::BufferStorage::MAP_READ) flags |= GL_MAP_READ_BIT;
+	if (storage & Atlas::BufferStorage::MAP_WRITE) flags |= GL_MAP_WRITE_BIT;
+	if (storage & Atlas::BufferStorage::PERSISTENT) flags |= GL_MAP_PERSISTENT_BIT;
+	if (storage & Atlas::BufferStorage::COHERENT) flags |= GL_MAP_COHERENT_BIT;
+	if (storage & Atlas::BufferStorage::DYNAMIC) flags |= GL_DYNAMIC_STORAGE_BIT;
+	return flags;
+}
+
+GLbitfield map_access_to_gl_flags(const Atlas::MapAccessBits access) {
+	GLbitfield flags = 0;
+	if (access & Atlas::MapAccess::READ) flags |= GL_MAP_READ_BIT;
+	if (access & Atlas::MapAccess::WRITE) flags |= GL_MAP_WRITE_BIT;
+	if (access & Atlas::MapAccess::INVALIDATE_RANGE) flags |= GL_MAP_INVALIDATE_RANGE_BIT;
+	if (access & Atlas::MapAccess::INVALIDATE_BUFFER) flags |= GL_MAP_INVALIDATE_BUFFER_BIT;
+	if (access & Atlas::MapAccess::UNSYNCHRONIZED) flags |= GL_MAP_UNSYNCHRONIZED_BIT;
+	if (access & Atlas::MapAccess::FLUSH_EXPLICIT) flags |= GL_MAP_FLUSH_EXPLICIT_BIT;
+	return flags;
+}
+
 GLenum shader_type_to_gl_enum(const Atlas::ShaderType type) {
 	switch (type)
 	{
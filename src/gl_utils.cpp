@@ -11,6 +11,8 @@
 
 #include <GLFW/glfw3.h>
 
+#include <iomanip>
+
 #include "Render2D.h"
 
 const char *gl_get_error_string(GLenum error)
@@ -34,6 +36,37 @@ namespace gl_utils {
 
 	static uint32_t s_GlobalVAO{ 0 };
 
+	struct ProgramCache {
+		static constexpr uint32_t MAGIC = 0x504c5441; // "ATLP"
+		static constexpr uint32_t VERSION = 1;
+
+		bool supported{ false };
+		std::filesystem::path directory{ "cache/shaders" };
+		std::string driver;
+	};
+
+	static ProgramCache s_ProgramCache;
+
+	// GL_KHR_parallel_shader_compile, not part of the generated glad loader
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+	typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+	static bool s_ParallelShaderCompile{ false };
+
+	// GL_ARB_gl_spirv, core since 4.6 but not part of the generated glad loader
+#define GL_SHADER_BINARY_FORMAT_SPIR_V_ARB 0x9551
+	typedef void (APIENTRYP PFNGLSPECIALIZESHADERPROC)(GLuint shader, const GLchar *pEntryPoint, GLuint numSpecializationConstants, const GLuint *pConstantIndex, const GLuint *pConstantValue);
+
+	struct SpirvLoader {
+		bool supported{ false };
+		std::filesystem::path directory{ "assets/shaders/spirv" };
+		PFNGLSPECIALIZESHADERPROC specialize{ nullptr };
+	};
+
+	static SpirvLoader s_Spirv;
+	static std::unordered_set<std::string> s_Extensions;
+
 	void create_texture2D(uint32_t width, uint32_t height, GLenum format, bool mipmap, GLenum minFilter, GLenum magFilter, uint32_t *texture) {
 		uint32_t id;
 		glCreateTextures(GL_TEXTURE_2D, 1, &id);
@@ -71,49 +104,136 @@ namespace gl_utils {
 		glTextureSubImage2D(texture, 0, 0, 0, width, height, dataFormat, GL_UNSIGNED_BYTE, data);
 	}
 
-	bool load_shader_module(const char *filePath, GLenum shaderType, uint32_t *shaderID) {
+	void clear_texture2D(uint32_t texture, GLenum format, GLenum type, const void *data)
+	{
+		glClearTexImage(texture, 0, format, type, data);
+	}
 
-		uint32_t id = glCreateShader(shaderType);
+	void clear_buffer(uint32_t buffer, size_t offset, size_t size, uint32_t value)
+	{
+		glClearNamedBufferSubData(buffer, GL_R32UI, offset, size, GL_RED_INTEGER, GL_UNSIGNED_INT, &value);
+	}
 
-		std::string shaderCode;
-		std::ifstream file(filePath, std::ios::in);
+	static bool preprocess_shader_file(const std::filesystem::path &path, std::unordered_set<std::string> &included, std::stringstream &out)
+	{
+		std::ifstream file(path, std::ios::in);
 
 		if (!file.is_open()) {
-			CORE_WARN("Could not find file: {}", filePath);
+			CORE_WARN("Could not find file: {}", path.string());
 			return false;
 		}
 
+		included.insert(path.lexically_normal().string());
+
+		std::string line;
+		uint32_t lineNumber = 0;
+
+		while (std::getline(file, line)) {
+			lineNumber++;
+
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+				out << line << '\n';
+				continue;
+			}
+
+			size_t open = line.find('"', start);
+			size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+			if (close == std::string::npos) {
+				CORE_WARN("{}({}): expected #include \"file\"", path.string(), lineNumber);
+				return false;
+			}
+
+			auto includePath = (path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal();
+
+			// every file is only included once
+			if (included.find(includePath.string()) == included.end()) {
+				out << "#line 1\n";
+				if (!preprocess_shader_file(includePath, included, out)) {
+					CORE_WARN("    included from {}({})", path.string(), lineNumber);
+					return false;
+				}
+			}
+
+			out << "#line " << lineNumber + 1 << '\n';
+		}
+
+		return true;
+	}
+
+	bool read_shader_source(const char *filePath, const GLShaderDefines &defines, std::string *source) {
+		std::unordered_set<std::string> included;
 		std::stringstream sstr;
-		sstr << file.rdbuf();
-		shaderCode = sstr.str();
-		file.close();
 
-		char const *sourcePtr = shaderCode.c_str();
+		if (!preprocess_shader_file(filePath, included, sstr)) return false;
+
+		*source = sstr.str();
+		if (defines.empty()) return true;
+
+		// defines have to follow the #version directive
+		size_t version = source->find("#version");
+		size_t insertAt = version == std::string::npos ? 0 : source->find('\n', version);
+		insertAt = insertAt == std::string::npos ? source->size() : insertAt + 1;
+
+		uint32_t nextLine = (uint32_t)std::count(source->begin(), source->begin() + insertAt, '\n') + 1;
+
+		std::stringstream defineBlock;
+		for (auto &[name, value] : defines) {
+			defineBlock << "#define " << name << " " << value << '\n';
+		}
+		defineBlock << "#line " << nextLine << '\n';
+
+		source->insert(insertAt, defineBlock.str());
+		return true;
+	}
+
+	uint32_t submit_shader_module(const std::string &source, GLenum shaderType) {
+
+		uint32_t id = glCreateShader(shaderType);
+
+		char const *sourcePtr = source.c_str();
 		glShaderSource(id, 1, &sourcePtr, nullptr);
 		glCompileShader(id);
 
+		return id;
+	}
+
+	bool check_shader_module(uint32_t shaderID, const char *name) {
 		int32_t res = GL_FALSE;
 		int infoLogLength;
 
-		glGetShaderiv(id, GL_COMPILE_STATUS, &res);
-		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &infoLogLength);
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &res);
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
 
 		if (infoLogLength > 0) {
 			std::string msg;
 			msg.resize(size_t(infoLogLength + 1));
 
 			//TODO: error handling
-			glGetShaderInfoLog(id, infoLogLength, nullptr, msg.data());
-			CORE_WARN("Shader Compilation: {}", filePath);
+			glGetShaderInfoLog(shaderID, infoLogLength, nullptr, msg.data());
+			CORE_WARN("Shader Compilation: {}", name);
 			CORE_WARN("{}", msg);
 			return false;
 		}
 
+		return true;
+	}
+
+	bool compile_shader_module(const std::string &source, const char *name, GLenum shaderType, uint32_t *shaderID) {
+		uint32_t id = submit_shader_module(source, shaderType);
+		if (!check_shader_module(id, name)) return false;
+
 		*shaderID = id;
 		return true;
 	}
 
-	bool link_shader_modules(uint32_t *modules, uint32_t moduleCount, uint32_t *programID) {
+	bool load_shader_module(const char *filePath, GLenum shaderType, uint32_t *shaderID, const GLShaderDefines &defines) {
+		std::string shaderCode;
+		if (!read_shader_source(filePath, defines, &shaderCode)) return false;
+		return compile_shader_module(shaderCode, filePath, shaderType, shaderID);
+	}
+
+	uint32_t submit_program(const uint32_t *modules, uint32_t moduleCount) {
 
 		uint32_t id = glCreateProgram();
 
@@ -121,25 +241,37 @@ namespace gl_utils {
 			glAttachShader(id, modules[i]);
 		}
 
+		if (s_ProgramCache.supported) glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 		glLinkProgram(id);
 
-		{
-			int32_t res = GL_FALSE;
-			int infoLogLength{};
-			glGetProgramiv(id, GL_LINK_STATUS, &res);
-			glGetProgramiv(id, GL_INFO_LOG_LENGTH, &infoLogLength);
-			if (infoLogLength > 0) {
-				std::string msg;
-				msg.resize(size_t(infoLogLength + 1));
-
-				//TODO: error handling
-				glGetProgramInfoLog(id, infoLogLength, nullptr, msg.data());
-				CORE_WARN("Shader Linking:");
-				CORE_WARN("{}", msg);
-				return false;
-			}
+		return id;
+	}
+
+	bool check_program(uint32_t programID) {
+		int32_t res = GL_FALSE;
+		int infoLogLength{};
+		glGetProgramiv(programID, GL_LINK_STATUS, &res);
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLength);
+		if (infoLogLength > 0) {
+			std::string msg;
+			msg.resize(size_t(infoLogLength + 1));
+
+			//TODO: error handling
+			glGetProgramInfoLog(programID, infoLogLength, nullptr, msg.data());
+			CORE_WARN("Shader Linking:");
+			CORE_WARN("{}", msg);
+			return false;
 		}
 
+		return true;
+	}
+
+	bool link_shader_modules(uint32_t *modules, uint32_t moduleCount, uint32_t *programID) {
+
+		uint32_t id = submit_program(modules, moduleCount);
+		if (!check_program(id)) return false;
+
 		for (uint32_t i = 0; i < moduleCount; i++) glDetachShader(id, modules[i]);
 
 		*programID = id;
@@ -249,6 +381,550 @@ namespace gl_utils {
 
 	}
 
+	template <typename T>
+	static void write_pod(std::ofstream &file, const T &value) {
+		file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	static bool read_pod(std::ifstream &file, T *value) {
+		return (bool)file.read(reinterpret_cast<char *>(value), sizeof(T));
+	}
+
+	static void write_string(std::ofstream &file, const std::string &str) {
+		write_pod(file, (uint32_t)str.size());
+		file.write(str.data(), str.size());
+	}
+
+	static bool read_string(std::ifstream &file, std::string *str) {
+		uint32_t size = 0;
+		if (!read_pod(file, &size)) return false;
+
+		// a corrupt size must not allocate more than the file could still hold
+		std::streampos position = file.tellg();
+		file.seekg(0, std::ios::end);
+		std::streampos end = file.tellg();
+		file.seekg(position);
+		if (position < 0 || end < position || (uint64_t)(end - position) < size) return false;
+
+		str->resize(size);
+		return (bool)file.read(str->data(), size);
+	}
+
+	// 64 bit FNV-1a, std::hash is not guaranteed to be stable between runs
+	static uint64_t hash_bytes(const char *data, size_t size, uint64_t hash = 0xcbf29ce484222325) {
+		for (size_t i = 0; i < size; i++) {
+			hash ^= (uint8_t)data[i];
+			hash *= 0x100000001b3;
+		}
+		return hash;
+	}
+
+	static std::filesystem::path program_cache_path(const std::string &key) {
+		return s_ProgramCache.directory / (key + ".bin");
+	}
+
+	void set_program_cache_dir(const std::string &directory)
+	{
+		s_ProgramCache.directory = directory;
+	}
+
+	std::string program_cache_key(const std::vector<std::pair<std::string, GLenum>> &sources)
+	{
+		uint64_t hash = hash_bytes(s_ProgramCache.driver.data(), s_ProgramCache.driver.size());
+
+		for (auto &[source, type] : sources) {
+			hash = hash_bytes(reinterpret_cast<const char *>(&type), sizeof(type), hash);
+			hash = hash_bytes(source.data(), source.size(), hash);
+		}
+
+		std::stringstream ss;
+		ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+		return ss.str();
+	}
+
+	bool load_program_binary(const std::string &key, uint32_t *programID, GLShaderReflectionData *data)
+	{
+		if (!s_ProgramCache.supported || s_ProgramCache.directory.empty()) return false;
+
+		auto path = program_cache_path(key);
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (!file.is_open()) return false;
+
+		uint32_t magic = 0, version = 0;
+		GLenum format = 0;
+		std::string binary;
+
+		if (!read_pod(file, &magic) || !read_pod(file, &version) || magic != ProgramCache::MAGIC || version != ProgramCache::VERSION) {
+			CORE_WARN("load_program_binary: invalid cache file: {}", path.string());
+			return false;
+		}
+
+		if (!read_pod(file, &format) || !read_string(file, &binary)) return false;
+
+		GLShaderReflectionData reflection{};
+		uint32_t count = 0;
+		bool ok = true;
+
+		ok = ok && read_pod(file, &count);
+		for (uint32_t i = 0; ok && i < count; i++) {
+			std::string name;
+			GLUniformInfo info{};
+			ok = read_string(file, &name) && read_pod(file, &info);
+			reflection.uniforms.insert({ name, info });
+		}
+
+		ok = ok && read_pod(file, &count);
+		for (uint32_t i = 0; ok && i < count; i++) {
+			std::string name;
+			GLUniformBlockInfo info{};
+			ok = read_string(file, &name) && read_pod(file, &info);
+			reflection.unifromBlocks.insert({ name, info });
+		}
+
+		ok = ok && read_pod(file, &count);
+		for (uint32_t i = 0; ok && i < count; i++) {
+			std::string name;
+			GLStorageBlockInfo info{};
+			ok = read_string(file, &name) && read_pod(file, &info);
+			reflection.storageBlocks.insert({ name, info });
+		}
+
+		if (!ok) {
+			CORE_WARN("load_program_binary: truncated cache file: {}", path.string());
+			return false;
+		}
+
+		uint32_t id = glCreateProgram();
+		glProgramBinary(id, format, binary.data(), (int)binary.size());
+
+		int32_t res = GL_FALSE;
+		glGetProgramiv(id, GL_LINK_STATUS, &res);
+		if (res != GL_TRUE) {
+			// the driver rejected the binary (e.g. after a driver update), recompile from source
+			glDeleteProgram(id);
+			return false;
+		}
+
+		*programID = id;
+		*data = std::move(reflection);
+		return true;
+	}
+
+	void store_program_binary(const std::string &key, uint32_t program, const GLShaderReflectionData &data)
+	{
+		if (!s_ProgramCache.supported || s_ProgramCache.directory.empty()) return;
+
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return;
+
+		std::string binary;
+		binary.resize(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		binary.resize(length);
+
+		std::error_code err;
+		std::filesystem::create_directories(s_ProgramCache.directory, err);
+		if (err) {
+			CORE_WARN("store_program_binary: could not create directory: {}", s_ProgramCache.directory.string());
+			return;
+		}
+
+		auto path = program_cache_path(key);
+		std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			CORE_WARN("store_program_binary: could not open file: {}", path.string());
+			return;
+		}
+
+		write_pod(file, ProgramCache::MAGIC);
+		write_pod(file, ProgramCache::VERSION);
+		write_pod(file, format);
+		write_string(file, binary);
+
+		write_pod(file, (uint32_t)data.uniforms.size());
+		for (auto &[name, info] : data.uniforms) {
+			write_string(file, name);
+			write_pod(file, info);
+		}
+
+		write_pod(file, (uint32_t)data.unifromBlocks.size());
+		for (auto &[name, info] : data.unifromBlocks) {
+			write_string(file, name);
+			write_pod(file, info);
+		}
+
+		write_pod(file, (uint32_t)data.storageBlocks.size());
+		for (auto &[name, info] : data.storageBlocks) {
+			write_string(file, name);
+			write_pod(file, info);
+		}
+	}
+
+	struct SpirvSpecConstant {
+		uint32_t id;
+		GLenum type;
+	};
+
+	// minimal SPIR-V parser, only collects what GLShaderReflectionData and the specialization need
+	static bool reflect_spirv(const std::vector<uint32_t> &code, GLShaderReflectionData *data, std::unordered_map<std::string, SpirvSpecConstant> *specConstants)
+	{
+		enum : uint32_t {
+			OP_NAME = 5, OP_DECORATE = 71, OP_MEMBER_DECORATE = 72,
+			OP_TYPE_BOOL = 20, OP_TYPE_INT = 21, OP_TYPE_FLOAT = 22, OP_TYPE_VECTOR = 23, OP_TYPE_MATRIX = 24,
+			OP_TYPE_IMAGE = 25, OP_TYPE_SAMPLED_IMAGE = 27, OP_TYPE_ARRAY = 28, OP_TYPE_RUNTIME_ARRAY = 29,
+			OP_TYPE_STRUCT = 30, OP_TYPE_POINTER = 32, OP_CONSTANT = 43,
+			OP_SPEC_CONSTANT_TRUE = 48, OP_SPEC_CONSTANT_FALSE = 49, OP_SPEC_CONSTANT = 50, OP_VARIABLE = 59,
+
+			DECORATION_SPEC_ID = 1, DECORATION_BLOCK = 2, DECORATION_BUFFER_BLOCK = 3, DECORATION_ARRAY_STRIDE = 6,
+			DECORATION_LOCATION = 30, DECORATION_BINDING = 33, DECORATION_OFFSET = 35,
+
+			STORAGE_UNIFORM_CONSTANT = 0, STORAGE_UNIFORM = 2, STORAGE_STORAGE_BUFFER = 12,
+		};
+
+		struct Type {
+			uint32_t op{ 0 };
+			std::vector<uint32_t> operands;
+		};
+
+		struct Id {
+			std::string name;
+			Type type;
+			std::unordered_map<uint32_t, uint32_t> decorations;
+			std::unordered_map<uint32_t, uint32_t> memberOffsets;
+			uint32_t constant{ 0 };
+		};
+
+		if (code.size() < 5 || code[0] != 0x07230203) return false;
+
+		std::vector<Id> ids(code[3]);
+		struct Variable {
+			uint32_t id;
+			uint32_t pointerType;
+			uint32_t storage;
+		};
+
+		std::vector<Variable> variables;
+		std::vector<uint32_t> specIds;
+
+		for (size_t i = 5; i < code.size();) {
+			uint32_t wordCount = code[i] >> 16;
+			uint32_t op = code[i] & 0xFFFF;
+			if (wordCount == 0 || i + wordCount > code.size()) return false;
+			const uint32_t *args = &code[i + 1];
+
+			switch (op) {
+			case OP_NAME:
+				if (wordCount >= 3 && args[0] < ids.size()) {
+					const char *name = reinterpret_cast<const char *>(&args[1]);
+					ids[args[0]].name = std::string(name, strnlen(name, (wordCount - 2) * sizeof(uint32_t)));
+				}
+				break;
+			case OP_DECORATE:
+				if (wordCount >= 4 && args[0] < ids.size()) ids[args[0]].decorations[args[1]] = args[2];
+				else if (wordCount == 3 && args[0] < ids.size()) ids[args[0]].decorations[args[1]] = 0;
+				break;
+			case OP_MEMBER_DECORATE:
+				if (wordCount >= 5 && args[2] == DECORATION_OFFSET && args[0] < ids.size()) ids[args[0]].memberOffsets[args[1]] = args[3];
+				break;
+			case OP_TYPE_BOOL: case OP_TYPE_INT: case OP_TYPE_FLOAT: case OP_TYPE_VECTOR: case OP_TYPE_MATRIX:
+			case OP_TYPE_IMAGE: case OP_TYPE_SAMPLED_IMAGE: case OP_TYPE_ARRAY: case OP_TYPE_RUNTIME_ARRAY:
+			case OP_TYPE_STRUCT: case OP_TYPE_POINTER:
+				if (args[0] < ids.size()) ids[args[0]].type = Type{ op, std::vector<uint32_t>(args + 1, args + wordCount - 1) };
+				break;
+			case OP_CONSTANT:
+				if (args[1] < ids.size()) ids[args[1]].constant = args[2];
+				break;
+			case OP_SPEC_CONSTANT_TRUE: case OP_SPEC_CONSTANT_FALSE: case OP_SPEC_CONSTANT:
+				if (args[1] < ids.size()) {
+					ids[args[1]].type.operands = { args[0] };
+					specIds.push_back(args[1]);
+				}
+				break;
+			case OP_VARIABLE:
+				if (wordCount >= 4) variables.push_back({ args[1], args[0], args[2] });
+				break;
+			}
+
+			i += wordCount;
+		}
+
+		auto get = [&](uint32_t id) -> const Id & {
+			static const Id empty{};
+			return id < ids.size() ? ids[id] : empty;
+		};
+
+		auto gl_type = [&](uint32_t typeID) -> GLenum {
+			const Type &type = get(typeID).type;
+
+			auto scalar = [&](uint32_t id) -> GLenum {
+				const Type &t = get(id).type;
+				if (t.op == OP_TYPE_FLOAT) return GL_FLOAT;
+				if (t.op == OP_TYPE_INT) return t.operands.size() > 1 && t.operands[1] ? GL_INT : GL_UNSIGNED_INT;
+				if (t.op == OP_TYPE_BOOL) return GL_BOOL;
+				return GL_NONE;
+			};
+
+			switch (type.op) {
+			case OP_TYPE_BOOL: case OP_TYPE_INT: case OP_TYPE_FLOAT:
+				return scalar(typeID);
+			case OP_TYPE_VECTOR: {
+				static const GLenum vecTypes[][3] = {
+					{ GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4 },
+					{ GL_INT_VEC2, GL_INT_VEC3, GL_INT_VEC4 },
+					{ GL_UNSIGNED_INT_VEC2, GL_UNSIGNED_INT_VEC3, GL_UNSIGNED_INT_VEC4 },
+					{ GL_BOOL_VEC2, GL_BOOL_VEC3, GL_BOOL_VEC4 },
+				};
+				GLenum component = scalar(type.operands[0]);
+				uint32_t row = component == GL_FLOAT ? 0 : component == GL_INT ? 1 : component == GL_UNSIGNED_INT ? 2 : 3;
+				uint32_t count = type.operands[1];
+				return count >= 2 && count <= 4 ? vecTypes[row][count - 2] : GL_NONE;
+			}
+			case OP_TYPE_MATRIX: {
+				uint32_t columns = type.operands[1];
+				uint32_t rows = get(type.operands[0]).type.operands[1];
+				if (columns == 2 && rows == 2) return GL_FLOAT_MAT2;
+				if (columns == 3 && rows == 3) return GL_FLOAT_MAT3;
+				if (columns == 4 && rows == 4) return GL_FLOAT_MAT4;
+				return GL_NONE;
+			}
+			case OP_TYPE_IMAGE:
+				// operands: sampled type, dim, depth, arrayed, ms, sampled
+				return type.operands[1] == 1 && type.operands[5] == 2 ? GL_IMAGE_2D : GL_NONE;
+			case OP_TYPE_SAMPLED_IMAGE:
+				return get(type.operands[0]).type.operands[1] == 1 ? GL_SAMPLER_2D : GL_NONE;
+			}
+			return GL_NONE;
+		};
+
+		std::function<int(uint32_t)> type_size = [&](uint32_t typeID) -> int {
+			const Id &id = get(typeID);
+			const Type &type = id.type;
+
+			switch (type.op) {
+			case OP_TYPE_BOOL: return 4;
+			case OP_TYPE_INT: case OP_TYPE_FLOAT: return (int)type.operands[0] / 8;
+			case OP_TYPE_VECTOR: return type_size(type.operands[0]) * (int)type.operands[1];
+			case OP_TYPE_MATRIX: {
+				// columns are vec4 aligned in both std140 and std430 except for 2 component columns
+				int column = type_size(type.operands[0]);
+				return (column == 8 ? 8 : 16) * (int)type.operands[1];
+			}
+			case OP_TYPE_ARRAY: {
+				auto stride = id.decorations.find(DECORATION_ARRAY_STRIDE);
+				int elementSize = stride != id.decorations.end() ? (int)stride->second : type_size(type.operands[0]);
+				return elementSize * (int)get(type.operands[1]).constant;
+			}
+			case OP_TYPE_STRUCT: {
+				int size = 0;
+				for (uint32_t m = 0; m < (uint32_t)type.operands.size(); m++) {
+					auto offset = id.memberOffsets.find(m);
+					int memberOffset = offset != id.memberOffsets.end() ? (int)offset->second : size;
+					size = std::max(size, memberOffset + type_size(type.operands[m]));
+				}
+				return size;
+			}
+			}
+			return 0;
+		};
+
+		auto decoration = [](const Id &id, uint32_t decoration, int fallback) {
+			auto it = id.decorations.find(decoration);
+			return it != id.decorations.end() ? (int)it->second : fallback;
+		};
+
+		for (auto &[variableID, pointerType, storage] : variables) {
+			const Id &variable = get(variableID);
+			const Type &pointer = get(pointerType).type;
+			if (pointer.op != OP_TYPE_POINTER || pointer.operands.size() < 2) continue;
+
+			uint32_t typeID = pointer.operands[1];
+			const Id &type = get(typeID);
+
+			if (storage == STORAGE_UNIFORM_CONSTANT) {
+				if (variable.name.empty()) continue;
+
+				std::string name = variable.name;
+				uint32_t elementType = typeID;
+				if (type.type.op == OP_TYPE_ARRAY) {
+					// GL reports uniform arrays by their first element
+					name += "[0]";
+					elementType = type.type.operands[0];
+				}
+
+				GLUniformInfo info{};
+				info.type = gl_type(elementType);
+				info.location = decoration(variable, DECORATION_LOCATION, -1);
+				info.size = type.type.op == OP_TYPE_ARRAY ? (int)get(type.type.operands[1]).constant : 1;
+				info.index = decoration(variable, DECORATION_BINDING, info.location);
+
+				if (info.location == -1) continue;
+				data->uniforms.insert({ name, info });
+			}
+			else if (storage == STORAGE_UNIFORM || storage == STORAGE_STORAGE_BUFFER) {
+				// blocks are looked up by their block name, the instance name is usually empty
+				std::string name = type.name.empty() ? variable.name : type.name;
+				int binding = decoration(variable, DECORATION_BINDING, 0);
+				int size = type_size(typeID);
+
+				if (storage == STORAGE_STORAGE_BUFFER || type.decorations.count(DECORATION_BUFFER_BLOCK)) {
+					GLStorageBlockInfo info{};
+					info.size = size;
+					info.binding = binding;
+					info.index = -1;
+					data->storageBlocks.insert({ name, info });
+				}
+				else {
+					GLUniformBlockInfo info{};
+					info.size = size;
+					info.binding = binding;
+					info.index = -1;
+					data->unifromBlocks.insert({ name, info });
+				}
+			}
+		}
+
+		for (auto specID : specIds) {
+			const Id &constant = get(specID);
+			auto it = constant.decorations.find(DECORATION_SPEC_ID);
+			if (it == constant.decorations.end() || constant.name.empty()) continue;
+
+			specConstants->insert({ constant.name, SpirvSpecConstant{ it->second, gl_type(constant.type.operands[0]) } });
+		}
+
+		return true;
+	}
+
+	static bool read_spirv_file(const std::filesystem::path &path, std::vector<uint32_t> *code)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return false;
+
+		size_t size = (size_t)file.tellg();
+		if (size == 0 || size % sizeof(uint32_t) != 0) return false;
+
+		code->resize(size / sizeof(uint32_t));
+		file.seekg(0);
+		return (bool)file.read(reinterpret_cast<char *>(code->data()), size);
+	}
+
+	// converts a define to the bit pattern glSpecializeShader expects
+	static bool spec_constant_value(const std::string &value, GLenum type, uint32_t *bits)
+	{
+		if (type == GL_BOOL) {
+			if (value == "true" || value == "1") *bits = 1;
+			else if (value == "false" || value == "0") *bits = 0;
+			else return false;
+			return true;
+		}
+
+		char *end = nullptr;
+		if (type == GL_FLOAT) {
+			float f = std::strtof(value.c_str(), &end);
+			std::memcpy(bits, &f, sizeof(f));
+		}
+		else if (type == GL_INT) {
+			*bits = (uint32_t)(int32_t)std::strtol(value.c_str(), &end, 0);
+		}
+		else if (type == GL_UNSIGNED_INT) {
+			*bits = (uint32_t)std::strtoul(value.c_str(), &end, 0);
+		}
+		else {
+			return false;
+		}
+
+		return end && *end == '\0' && !value.empty();
+	}
+
+	// the newest write time of source and every file it includes, false if the source is not there to compare against
+	static bool newest_source_time(const std::filesystem::path &source, std::filesystem::file_time_type *time)
+	{
+		std::error_code err;
+		if (!std::filesystem::exists(source, err)) return false;
+
+		std::unordered_set<std::string> included;
+		std::stringstream discard;
+		// a source that doesn't preprocess counts as changed, the GLSL path reports why
+		if (!preprocess_shader_file(source, included, discard)) {
+			*time = std::filesystem::file_time_type::max();
+			return true;
+		}
+
+		*time = std::filesystem::file_time_type::min();
+		for (auto &file : included) {
+			auto fileTime = std::filesystem::last_write_time(file, err);
+			if (!err) *time = std::max(*time, fileTime);
+		}
+		return true;
+	}
+
+	void set_spirv_dir(const std::string &directory)
+	{
+		s_Spirv.directory = directory;
+	}
+
+	bool submit_spirv_program(const std::vector<std::pair<std::string, GLenum>> &modules, const GLShaderDefines &defines, uint32_t *programID, std::vector<uint32_t> *shaders, GLShaderReflectionData *data)
+	{
+		if (!s_Spirv.supported || s_Spirv.directory.empty()) return false;
+
+		GLShaderReflectionData reflection{};
+		std::vector<uint32_t> moduleIDs;
+
+		auto cleanup = [&]() {
+			for (auto id : moduleIDs) glDeleteShader(id);
+		};
+
+		for (auto &[file, type] : modules) {
+			std::filesystem::path source(file);
+			std::filesystem::path path = s_Spirv.directory / (source.filename().string() + ".spv");
+
+			// the GLSL source and its includes are the reference, a binary older than any of them was not rebuilt yet
+			std::error_code err;
+			auto binaryTime = std::filesystem::last_write_time(path, err);
+			if (err) { cleanup(); return false; }
+			std::filesystem::file_time_type sourceTime;
+			if (newest_source_time(source, &sourceTime) && sourceTime > binaryTime) {
+				CORE_TRACE("submit_spirv_program: {} is out of date, compiling from source", path.string());
+				cleanup();
+				return false;
+			}
+
+			std::vector<uint32_t> code;
+			std::unordered_map<std::string, SpirvSpecConstant> specConstants;
+			if (!read_spirv_file(path, &code) || !reflect_spirv(code, &reflection, &specConstants)) {
+				CORE_WARN("submit_spirv_program: invalid SPIR-V module: {}", path.string());
+				cleanup();
+				return false;
+			}
+
+			std::vector<uint32_t> indices;
+			std::vector<uint32_t> values;
+			for (auto &[name, value] : defines) {
+				auto it = specConstants.find(name);
+				uint32_t bits = 0;
+				if (it == specConstants.end() || !spec_constant_value(value, it->second.type, &bits)) {
+					// plain defines can only be honoured by the GLSL path
+					cleanup();
+					return false;
+				}
+				indices.push_back(it->second.id);
+				values.push_back(bits);
+			}
+
+			uint32_t id = glCreateShader(type);
+			moduleIDs.push_back(id);
+			glShaderBinary(1, &id, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, code.data(), (int)(code.size() * sizeof(uint32_t)));
+			s_Spirv.specialize(id, "main", (uint32_t)indices.size(), indices.data(), values.data());
+		}
+
+		*programID = submit_program(moduleIDs.data(), (uint32_t)moduleIDs.size());
+		*shaders = std::move(moduleIDs);
+		*data = std::move(reflection);
+		return true;
+	}
+
 	void resize_viewport(uint32_t width, uint32_t height)
 	{
 		glViewport(0, 0, width, height);
@@ -281,10 +957,15 @@ namespace gl_utils {
 	//}
 
 	GLBuffer::GLBuffer(const GLBufferCreateInfo &info)
-		:m_Size(info.size)
+		:m_Size(info.size), m_Immutable(info.immutable), m_StorageFlags(info.storageFlags)
 	{
 		glCreateBuffers(1, &m_ID);
 
+		if (m_Immutable) {
+			glNamedBufferStorage(m_ID, m_Size, info.data, m_StorageFlags);
+			return;
+		}
+
 		if (info.data == nullptr) {
 			glNamedBufferData(m_ID, m_Size, nullptr, info.usage);
 			return;
@@ -294,17 +975,168 @@ namespace gl_utils {
 		}
 	}
 
-	void GLBuffer::set_data(void *data, size_t size)
+	void GLBuffer::set_data(const void *data, size_t offset, size_t size)
+	{
+		CORE_ASSERT(offset + size <= m_Size, "GLBuffer::set_data error: range has to be inside the buffer");
+		if (size == 0) return;
+		glNamedBufferSubData(m_ID, offset, size, data);
+	}
+
+	void GLBuffer::invalidate()
+	{
+		glInvalidateBufferData(m_ID);
+	}
+
+	void *GLBuffer::map_persistent()
+	{
+		CORE_ASSERT(m_StorageFlags & GL_MAP_PERSISTENT_BIT, "GLBuffer::map_persistent: buffer was not created with GL_MAP_PERSISTENT_BIT");
+		if (m_PersistentPtr) return m_PersistentPtr;
+
+		GLbitfield access = m_StorageFlags & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+		if (!(access & GL_MAP_COHERENT_BIT) && (access & GL_MAP_WRITE_BIT)) access |= GL_MAP_FLUSH_EXPLICIT_BIT;
+
+		m_PersistentPtr = glMapNamedBufferRange(m_ID, 0, m_Size, access);
+		return m_PersistentPtr;
+	}
+
+	void *GLBuffer::map_range(size_t offset, size_t size, GLbitfield access)
+	{
+		CORE_ASSERT(offset + size <= m_Size, "GLBuffer::map_range: range has to be inside the buffer");
+		CORE_ASSERT(!m_PersistentPtr, "GLBuffer::map_range: buffer is persistently mapped");
+		return glMapNamedBufferRange(m_ID, offset, size, access);
+	}
+
+	void GLBuffer::unmap()
+	{
+		glUnmapNamedBuffer(m_ID);
+	}
+
+	void GLBuffer::flush_range(size_t offset, size_t size)
 	{
-		CORE_ASSERT(size <= m_Size, "GLBuffer::set_data error: size has to be smaller or equal than the size of the buffer");
-		glNamedBufferSubData(m_ID, 0, m_Size, data);
+		glFlushMappedNamedBufferRange(m_ID, offset, size);
 	}
 
 	GLBuffer::~GLBuffer()
 	{
+		if (m_PersistentPtr) glUnmapNamedBuffer(m_ID);
 		glDeleteBuffers(1, &m_ID);
 	}
 
+	GLFence::GLFence()
+	{
+		m_Sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GLFence::~GLFence()
+	{
+		glDeleteSync(m_Sync);
+	}
+
+	bool GLFence::is_signaled()
+	{
+		GLenum res = glClientWaitSync(m_Sync, m_Flushed ? 0 : GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		m_Flushed = true;
+		return res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED;
+	}
+
+	bool GLFence::wait(uint64_t timeout)
+	{
+		// flush, otherwise the fence may never reach the GPU
+		GLenum res = glClientWaitSync(m_Sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		m_Flushed = true;
+		return res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED;
+	}
+
+	struct StagingBuffer {
+		uint32_t id;
+		size_t capacity;
+	};
+
+	// released staging buffers are reused by later readbacks of the same or smaller size
+	static std::vector<StagingBuffer> s_StagingBuffers;
+	static constexpr size_t MAX_STAGING_BUFFERS = 16;
+
+	static GLReadback acquire_readback(size_t size)
+	{
+		GLReadback readback{};
+		readback.size = size;
+
+		auto best = s_StagingBuffers.end();
+		for (auto it = s_StagingBuffers.begin(); it != s_StagingBuffers.end(); it++) {
+			if (it->capacity >= size && (best == s_StagingBuffers.end() || it->capacity < best->capacity)) best = it;
+		}
+
+		if (best != s_StagingBuffers.end()) {
+			readback.buffer = best->id;
+			readback.capacity = best->capacity;
+			s_StagingBuffers.erase(best);
+			return readback;
+		}
+
+		glCreateBuffers(1, &readback.buffer);
+		glNamedBufferStorage(readback.buffer, size, nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+		readback.capacity = size;
+		return readback;
+	}
+
+	GLReadback read_buffer_async(uint32_t buffer, size_t offset, size_t size)
+	{
+		GLReadback readback = acquire_readback(size);
+
+		// make shader storage writes visible to the copy
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glCopyNamedBufferSubData(buffer, readback.buffer, offset, 0, size);
+
+		return readback;
+	}
+
+	GLReadback read_texture_async(uint32_t texture, int x, int y, int width, int height, GLenum format, GLenum type, size_t size)
+	{
+		GLReadback readback = acquire_readback(size);
+
+		// make image stores visible to the pixel pack
+		glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTextureSubImage(texture, 0, x, y, 0, width, height, 1, format, type, (int)size, nullptr);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		return readback;
+	}
+
+	void read_texture(uint32_t texture, GLenum format, GLenum type, void *data, size_t size)
+	{
+		glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTextureImage(texture, 0, format, type, (int)size, data);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	}
+
+	const void *map_readback(GLReadback *readback)
+	{
+		if (!readback->mapped) {
+			readback->mapped = true;
+			return glMapNamedBufferRange(readback->buffer, 0, readback->size, GL_MAP_READ_BIT);
+		}
+
+		void *data = nullptr;
+		glGetNamedBufferPointerv(readback->buffer, GL_BUFFER_MAP_POINTER, &data);
+		return data;
+	}
+
+	void release_readback(GLReadback *readback)
+	{
+		if (readback->mapped) glUnmapNamedBuffer(readback->buffer);
+
+		if (s_StagingBuffers.size() < MAX_STAGING_BUFFERS) s_StagingBuffers.push_back({ readback->buffer, readback->capacity });
+		else glDeleteBuffers(1, &readback->buffer);
+
+		*readback = GLReadback{};
+	}
+
 	void bind_uniform_buffer(const Ref<GLBuffer> &buffer, uint32_t blockBinding, uint32_t offset)
 	{
 		glBindBufferRange(GL_UNIFORM_BUFFER, blockBinding, buffer->id(), offset, buffer->size());
@@ -373,24 +1205,118 @@ namespace gl_utils {
 
 	GLShader::GLShader(const GLShaderCreateInfo &info)
 	{
-		std::vector<uint32_t> modules;
-		modules.resize(info.size());
+		if (submit_spirv_program(info.modules, info.defines, &m_ID, &m_Modules, &m_ReflectionData)) {
+			// bindings, locations and specialization were baked in offline
+			m_Spirv = true;
+			for (auto &module : info.modules) m_ModuleNames.push_back(module.first);
+			m_SourceInfo = make_scope<GLShaderCreateInfo>(info);
+			m_State = State::COMPILING;
+		}
+		else {
+			submit_source(info);
+		}
+
+		if (!info.async) finalize();
+	}
 
-		for (uint32_t i = 0; i < (uint32_t)info.size(); i++) {
-			auto &pair = info.at(i);
-			if (!load_shader_module(pair.first.c_str(), pair.second, &modules.at(i))) {
-				CORE_WARN("GLShader::GLShader: error while compiling module: {}", pair.first);
+	void GLShader::submit_source(const GLShaderCreateInfo &info)
+	{
+		std::vector<std::pair<std::string, GLenum>> sources;
+		sources.resize(info.modules.size());
+
+		for (uint32_t i = 0; i < (uint32_t)info.modules.size(); i++) {
+			auto &pair = info.modules.at(i);
+			sources.at(i).second = pair.second;
+			if (!read_shader_source(pair.first.c_str(), info.defines, &sources.at(i).first)) {
+				CORE_WARN("GLShader::GLShader: error while loading module: {}", pair.first);
 				return;
 			}
 		}
 
-		if (!link_shader_modules(modules.data(), (uint32_t)modules.size(), &m_ID)) {
-			CORE_WARN("GLShader::GLShader: error while compiling shader");
+		m_CacheKey = program_cache_key(sources);
+
+		if (load_program_binary(m_CacheKey, &m_ID, &m_ReflectionData)) {
+			bind_resources();
+			m_State = State::READY;
+			return;
+		}
+
+		for (uint32_t i = 0; i < (uint32_t)info.modules.size(); i++) {
+			m_Modules.push_back(submit_shader_module(sources.at(i).first, sources.at(i).second));
+			m_ModuleNames.push_back(info.modules.at(i).first);
+		}
+
+		m_ID = submit_program(m_Modules.data(), (uint32_t)m_Modules.size());
+		m_State = State::COMPILING;
+	}
+
+	bool GLShader::is_ready()
+	{
+		if (m_State == State::COMPILING) {
+			int completed = GL_TRUE;
+			if (s_ParallelShaderCompile) glGetProgramiv(m_ID, GL_COMPLETION_STATUS_KHR, &completed);
+			if (completed) finalize();
+		}
+
+		return m_State == State::READY;
+	}
+
+	void GLShader::finalize()
+	{
+		if (m_State != State::COMPILING) return;
+		ATL_EVENT();
+
+		bool success = true;
+		for (uint32_t i = 0; i < (uint32_t)m_Modules.size() && success; i++) {
+			success = check_shader_module(m_Modules.at(i), m_ModuleNames.at(i).c_str());
+		}
+
+		if (success) success = check_program(m_ID);
+
+		for (auto i : m_Modules) {
+			glDetachShader(m_ID, i);
+			glDeleteShader(i);
+		}
+		m_Modules.clear();
+
+		if (!success && m_Spirv) {
+			// the binaries didn't match the driver or the sources, the GLSL path can still build the program
+			CORE_WARN("GLShader::finalize: SPIR-V program failed, compiling from source");
+			glDeleteProgram(m_ID);
+			m_ID = 0;
+			m_Spirv = false;
+			m_ModuleNames.clear();
+			m_ReflectionData = GLShaderReflectionData{};
+
+			Scope<GLShaderCreateInfo> info = std::move(m_SourceInfo);
+			m_State = State::FAILED;
+			submit_source(*info);
+			finalize();
+			return;
+		}
+
+		if (!success) {
+			CORE_WARN("GLShader::finalize: error while compiling shader");
+			glDeleteProgram(m_ID);
+			m_ID = 0;
+			m_State = State::FAILED;
+			return;
 		}
 
-		for (auto i : modules) glDeleteShader(i);
+		m_SourceInfo.reset();
+		m_State = State::READY;
+
+		// SPIR-V was reflected from the binaries and isn't worth a program binary of its own
+		if (m_Spirv) return;
 
 		reflect_shader(m_ID, &m_ReflectionData);
+		bind_resources();
+		store_program_binary(m_CacheKey, m_ID, m_ReflectionData);
+	}
+
+	void GLShader::bind_resources()
+	{
+		if (m_Spirv) return;
 
 		for (auto &block : m_ReflectionData.unifromBlocks) {
 			if (block.second.binding == 0) block.second.binding = block.second.index;
@@ -404,13 +1330,15 @@ namespace gl_utils {
 
 		for (auto &uniform : m_ReflectionData.uniforms) {
 			if (uniform.second.type == GL_IMAGE_2D || uniform.second.type == GL_SAMPLER_2D) {
-				set_int(uniform.first.c_str(), uniform.second.index);
+				glProgramUniform1i(m_ID, uniform.second.location, uniform.second.index);
 			}
 		}
 	}
 
 	GLShader::~GLShader()
 	{
+		// modules of a program that never finished compiling
+		for (auto i : m_Modules) glDeleteShader(i);
 		glDeleteProgram(m_ID);
 	}
 
@@ -526,6 +1454,7 @@ namespace gl_utils {
 
 	GLUniformInfo *GLShader::get_uniform_info(const std::string &name)
 	{
+		finalize();
 		if (m_ReflectionData.uniforms.find(name) == m_ReflectionData.uniforms.end()) {
 			return nullptr;
 		}
@@ -535,6 +1464,7 @@ namespace gl_utils {
 
 	int GLShader::get_uniform_location(const std::string &name)
 	{
+		finalize();
 		if (m_ReflectionData.uniforms.find(name) == m_ReflectionData.uniforms.end()) {
 			CORE_WARN("GLShader::get_uniform_location: could not find uniform: {}", name);
 			return -1;
@@ -545,6 +1475,7 @@ namespace gl_utils {
 
 	int GLShader::get_uniform_block_binding(const std::string &name)
 	{
+		finalize();
 		const auto &it = m_ReflectionData.unifromBlocks.find(name);
 		if (it == m_ReflectionData.unifromBlocks.end()) {
 			return -1;
@@ -555,6 +1486,7 @@ namespace gl_utils {
 
 	int GLShader::get_storage_block_binding(const std::string &name)
 	{
+		finalize();
 		const auto it = m_ReflectionData.storageBlocks.find(name);
 		if (it == m_ReflectionData.storageBlocks.end()) {
 			return -1;
@@ -627,18 +1559,28 @@ namespace gl_utils {
 		else if (type == GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR) sType = "DEPRECATED";
 		else return;
 
-		if (severity == GL_DEBUG_SEVERITY_LOW) {
-			CORE_TRACE("OpenGL {}: {}", sType, gl_get_error_string(type));
-			CORE_TRACE("{}", message);
-		}
-		else if (severity == GL_DEBUG_SEVERITY_MEDIUM) {
-			CORE_WARN("OpenGL {}: {}", sType, gl_get_error_string(type));
-			CORE_WARN("{}", message);
-		}
-		else if (severity == GL_DEBUG_SEVERITY_HIGH) {
-			CORE_ERROR("OpenGL {}: {}", sType, gl_get_error_string(type));
-			CORE_ERROR("{}", message);
-		}
+		// one line per message so repeats of it are deduplicated
+		if (severity == GL_DEBUG_SEVERITY_LOW) CORE_TRACE("OpenGL {} ({}): {}", sType, gl_get_error_string(type), message);
+		else if (severity == GL_DEBUG_SEVERITY_MEDIUM) CORE_WARN("OpenGL {} ({}): {}", sType, gl_get_error_string(type), message);
+		else if (severity == GL_DEBUG_SEVERITY_HIGH) CORE_ERROR("OpenGL {} ({}): {}", sType, gl_get_error_string(type), message);
+	}
+
+	bool has_extension(const char *name)
+	{
+		return s_Extensions.find(name) != s_Extensions.end();
+	}
+
+	static GLADloadproc s_ProcLoader = nullptr;
+
+	bool load_opengl(GLADloadproc loader)
+	{
+		s_ProcLoader = loader;
+		return gladLoadGLLoader(loader);
+	}
+
+	void *get_proc_address(const char *name)
+	{
+		return s_ProcLoader ? s_ProcLoader(name) : nullptr;
 	}
 
 	void init_opengl()
@@ -650,18 +1592,37 @@ namespace gl_utils {
 		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
 		glDebugMessageCallback(gl_debug_msg, 0);
 
-		bool supported = false;
 		{
 			GLint numExtensions;
 			glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
 			for (int i = 0; i < numExtensions; ++i) {
-				if (std::string((const char *)glGetStringi(GL_EXTENSIONS, i)) == "GL_ARB_compute_shader") {
-					supported = true;
-					break;
-				}
+				s_Extensions.insert((const char *)glGetStringi(GL_EXTENSIONS, i));
 			}
 		}
 
+		bool supported = has_extension("GL_ARB_compute_shader");
+
+		{
+			auto maxCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)get_proc_address("glMaxShaderCompilerThreadsKHR");
+			if (!maxCompilerThreads) maxCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)get_proc_address("glMaxShaderCompilerThreadsARB");
+
+			s_ParallelShaderCompile = maxCompilerThreads
+				&& (has_extension("GL_KHR_parallel_shader_compile") || has_extension("GL_ARB_parallel_shader_compile"));
+
+			// 0xFFFFFFFF lets the driver pick the number of compiler threads
+			if (s_ParallelShaderCompile) maxCompilerThreads(0xFFFFFFFF);
+		}
+
+		{
+			GLint major = 0, minor = 0;
+			glGetIntegerv(GL_MAJOR_VERSION, &major);
+			glGetIntegerv(GL_MINOR_VERSION, &minor);
+			bool core = major > 4 || (major == 4 && minor >= 6);
+
+			s_Spirv.specialize = (PFNGLSPECIALIZESHADERPROC)get_proc_address(core ? "glSpecializeShader" : "glSpecializeShaderARB");
+			s_Spirv.supported = s_Spirv.specialize && (core || has_extension("GL_ARB_gl_spirv"));
+		}
+
 		glCreateVertexArrays(1, &s_GlobalVAO);
 		glBindVertexArray(s_GlobalVAO);
 
@@ -670,11 +1631,22 @@ namespace gl_utils {
 		glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 1, &workGroupSize[1]);
 		glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 2, &workGroupSize[2]);
 
+		{
+			GLint binaryFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+			s_ProgramCache.supported = binaryFormats > 0;
+			s_ProgramCache.driver = std::string((const char *)glGetString(GL_VENDOR)) + "/"
+				+ (const char *)glGetString(GL_RENDERER) + "/" + (const char *)glGetString(GL_VERSION);
+		}
+
 		CORE_TRACE("OpenGL Info:");
 		CORE_TRACE(" vendor:	{}", (const char *)glGetString(GL_VENDOR));
 		CORE_TRACE(" renderer:	{}", (const char *)glGetString(GL_RENDERER));
 		CORE_TRACE(" version:	{}", (const char *)glGetString(GL_VERSION));
 		CORE_TRACE(" compute support:	{}", supported);
-		if (supported) CORE_TRACE(" work groups:	({}, {}, {})\n", workGroupSize[0], workGroupSize[1], workGroupSize[2]);
+		if (supported) CORE_TRACE(" work groups:	({}, {}, {})", workGroupSize[0], workGroupSize[1], workGroupSize[2]);
+		CORE_TRACE(" program binaries:	{}", s_ProgramCache.supported);
+		CORE_TRACE(" SPIR-V shaders:	{}", s_Spirv.supported);
+		CORE_TRACE(" parallel shader compile:	{}\n", s_ParallelShaderCompile);
 	}
 }
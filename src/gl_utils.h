@@ -42,13 +42,40 @@ namespace gl_utils {
 
 	void create_texture2D(uint32_t width, uint32_t height, GLenum format, bool mipmap, uint32_t *texture);
 	void set_texture2D_data(uint32_t texture, uint32_t width, uint32_t height, GLenum dataFormat, const void *data);
-
-	bool load_shader_module(const char *filePath, GLenum shaderType, uint32_t *shaderID);
+	void clear_texture2D(uint32_t texture, GLenum format, GLenum type, const void *data);
+	void clear_buffer(uint32_t buffer, size_t offset, size_t size, uint32_t value);
+
+	using GLShaderDefines = std::map<std::string, std::string>;
+
+	// resolves #include "file" relative to the including file and injects the defines after #version
+	bool read_shader_source(const char *filePath, const GLShaderDefines &defines, std::string *source);
+	uint32_t submit_shader_module(const std::string &source, GLenum shaderType);
+	bool check_shader_module(uint32_t shaderID, const char *name);
+	bool compile_shader_module(const std::string &source, const char *name, GLenum shaderType, uint32_t *shaderID);
+	bool load_shader_module(const char *filePath, GLenum shaderType, uint32_t *shaderID, const GLShaderDefines &defines = {});
+	uint32_t submit_program(const uint32_t *modules, uint32_t moduleCount);
+	bool check_program(uint32_t programID);
 	bool link_shader_modules(uint32_t *modules, uint32_t moduleCount, uint32_t *programID);
 	void reflect_shader(uint32_t program, GLShaderReflectionData *data);
 
+	// program binaries are cached on disk, keyed by the shader sources and the driver
+	void set_program_cache_dir(const std::string &directory);
+	std::string program_cache_key(const std::vector<std::pair<std::string, GLenum>> &sources);
+	bool load_program_binary(const std::string &key, uint32_t *programID, GLShaderReflectionData *data);
+	void store_program_binary(const std::string &key, uint32_t program, const GLShaderReflectionData &data);
+
+	// offline compiled modules are looked up as <directory>/<source file name>.spv, defines become specialization constants.
+	// like submit_program it only specializes and links, the modules and program are checked by the caller
+	void set_spirv_dir(const std::string &directory);
+	bool submit_spirv_program(const std::vector<std::pair<std::string, GLenum>> &modules, const GLShaderDefines &defines, uint32_t *programID, std::vector<uint32_t> *shaders, GLShaderReflectionData *data);
+
 	void resize_viewport(uint32_t width, uint32_t height);
 
+	bool has_extension(const char *name);
+
+	// loads the GL functions through the loader of the current context, glfw or egl
+	bool load_opengl(GLADloadproc loader);
+	void *get_proc_address(const char *name);
 	void init_opengl();
 
 	struct GLTexture2DCreateInfo {
@@ -88,6 +115,10 @@ namespace gl_utils {
 		GLenum usage;
 		size_t size;
 		void *data;
+
+		// glNamedBufferStorage flags, used instead of usage when immutable is set
+		bool immutable{ false };
+		GLbitfield storageFlags{ 0 };
 	};
 
 	class GLBuffer {
@@ -97,7 +128,18 @@ namespace gl_utils {
 		GLBuffer(const GLBuffer &) = delete;
 		~GLBuffer();
 
-		void set_data(void *data, size_t size);
+		void set_data(const void *data, size_t offset, size_t size);
+
+		// orphans the storage, later writes don't wait for draws still reading the old contents
+		void invalidate();
+
+		void *map_persistent();
+		void *map_range(size_t offset, size_t size, GLbitfield access);
+		void unmap();
+		void flush_range(size_t offset, size_t size);
+
+		inline bool is_immutable() const { return m_Immutable; }
+		inline GLbitfield storage_flags() const { return m_StorageFlags; }
 
 		inline size_t size() const { return m_Size; }
 		inline uint32_t id() const { return m_ID; }
@@ -105,14 +147,56 @@ namespace gl_utils {
 	private:
 		size_t m_Size;
 		uint32_t m_ID{ 0 };
+
+		bool m_Immutable{ false };
+		GLbitfield m_StorageFlags{ 0 };
+		void *m_PersistentPtr{ nullptr };
 	};
 
+	class GLFence {
+	public:
+
+		// inserted into the command stream on construction
+		GLFence();
+		GLFence(const GLFence &) = delete;
+		~GLFence();
+
+		// the first poll flushes, without a swap nothing else may submit the fence to the GPU
+		bool is_signaled();
+		bool wait(uint64_t timeout);
+
+	private:
+		GLsync m_Sync{ nullptr };
+		bool m_Flushed{ false };
+	};
+
+	// copy into a staging buffer, the data can be mapped once the GPU finished the frame it was recorded in
+	struct GLReadback {
+		uint32_t buffer{ 0 };
+		size_t capacity{ 0 };
+		size_t size{ 0 };
+		bool mapped{ false };
+	};
+
+	GLReadback read_buffer_async(uint32_t buffer, size_t offset, size_t size);
+	GLReadback read_texture_async(uint32_t texture, int x, int y, int width, int height, GLenum format, GLenum type, size_t size);
+	// blocking, waits for the GPU to finish writing the texture
+	void read_texture(uint32_t texture, GLenum format, GLenum type, void *data, size_t size);
+	const void *map_readback(GLReadback *readback);
+	void release_readback(GLReadback *readback);
+
 	void bind_uniform_buffer(const Ref<GLBuffer> &buffer, uint32_t blockBinding, uint32_t offset = 0);
 	void bind_vertex_buffer(const Ref<GLBuffer> &GLBuffer, size_t stride, uint32_t indx = 0, uint32_t offset = 0);
 	void bind_index_buffer(const Ref<GLBuffer> &buffer);
 	void bind_storage_buffer(const Ref<GLBuffer> &buffer, uint32_t blockBinding, uint32_t offset = 0);
 
-	using GLShaderCreateInfo = std::vector<std::pair<std::string, GLenum>>;
+	struct GLShaderCreateInfo {
+		std::vector<std::pair<std::string, GLenum>> modules;
+		GLShaderDefines defines;
+
+		// only submit the modules, compile and link status is checked on first use
+		bool async{ false };
+	};
 
 	class GLShader {
 	public:
@@ -121,6 +205,9 @@ namespace gl_utils {
 		GLShader(const GLShader &) = delete;
 		~GLShader();
 
+		// does not block if GL_KHR_parallel_shader_compile is supported
+		bool is_ready();
+
 		//void bind();
 
 		void set_int(const char *name, int32_t value);
@@ -151,11 +238,30 @@ namespace gl_utils {
 		int get_uniform_block_binding(const std::string &name);
 		int get_storage_block_binding(const std::string &name);
 
-		inline uint32_t id() { return m_ID; }
+		inline uint32_t id() { finalize(); return m_ID; }
 
 	private:
+		enum class State {
+			COMPILING,
+			READY,
+			FAILED,
+		};
+
+		void submit_source(const GLShaderCreateInfo &info);
+		void finalize();
+		void bind_resources();
+
 		uint32_t m_ID{ 0 };
 		GLShaderReflectionData m_ReflectionData;
+
+		State m_State{ State::FAILED };
+		bool m_Spirv{ false };
+		std::vector<uint32_t> m_Modules;
+		std::vector<std::string> m_ModuleNames;
+		std::string m_CacheKey;
+
+		// kept while a SPIR-V program compiles, it's rebuilt from source if the binaries turn out to be unusable
+		Scope<GLShaderCreateInfo> m_SourceInfo;
 	};
 
 	void bind_shader(Ref<GLShader> shader);
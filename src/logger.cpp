@@ -2,20 +2,115 @@
 
 #include <spdlog/sinks/ostream_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/sinks/dup_filter_sink.h>
+#include <spdlog/async.h>
+
+#include <chrono>
 
 std::shared_ptr<spdlog::logger> Logger::s_CoreLogger;
 std::shared_ptr<spdlog::logger> Logger::s_ClientLogger;
 std::ostringstream Logger::s_OStream;
 
+static std::atomic<uint32_t> s_RateLimit{ 10 };
+
+// console output happens on spdlog's worker thread, a full queue drops the oldest message instead of blocking the caller
+static std::shared_ptr<spdlog::logger> create_async_logger(const std::string &name)
+{
+	auto console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+
+	// repeats of the same message within the window collapse into one line with their count
+	auto dedup = std::make_shared<spdlog::sinks::dup_filter_sink_mt>(std::chrono::seconds(5));
+	dedup->add_sink(console);
+
+	auto logger = std::make_shared<spdlog::async_logger>(name, dedup, spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+	spdlog::initialize_logger(logger);
+	return logger;
+}
+
 void Logger::init() {
 	auto ostreamSink =
 		std::make_shared<spdlog::sinks::ostream_sink_st>(s_OStream);
 
 	spdlog::set_pattern("%^%n (%T) [%l]: %v%$");
+	spdlog::init_thread_pool(8192, 1);
 
-	s_CoreLogger = spdlog::stdout_color_mt("CORE");
+	s_CoreLogger = create_async_logger("CORE");
 	s_CoreLogger->set_level(spdlog::level::trace);
+	s_CoreLogger->flush_on(spdlog::level::err);
 
-	s_ClientLogger = spdlog::stdout_color_mt("APP");
+	s_ClientLogger = create_async_logger("APP");
 	s_ClientLogger->set_level(spdlog::level::trace);
+	s_ClientLogger->flush_on(spdlog::level::err);
+
+	spdlog::flush_every(std::chrono::seconds(1));
+}
+
+void Logger::set_rate_limit(uint32_t messagesPerSecond)
+{
+	s_RateLimit = messagesPerSecond;
+}
+
+uint32_t Logger::get_rate_limit()
+{
+	return s_RateLimit;
+}
+
+void Logger::shutdown()
+{
+	spdlog::shutdown();
+}
+
+bool LogSite::allow(uint32_t &suppressed)
+{
+	suppressed = 0;
+	uint32_t limit = s_RateLimit.load(std::memory_order_relaxed);
+	if (limit == 0) return true;
+
+	// one second windows, whoever moves the window on reports what the last one dropped
+	int64_t now = ScopeTimer::now_ns();
+	int64_t start = m_WindowStart.load(std::memory_order_relaxed);
+	if (now - start >= 1000000000 && m_WindowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+		m_Count.store(0, std::memory_order_relaxed);
+		suppressed = m_Suppressed.exchange(0, std::memory_order_relaxed);
+	}
+
+	if (m_Count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+
+	m_Suppressed.fetch_add(suppressed + 1, std::memory_order_relaxed);
+	suppressed = 0;
+	return false;
+}
+
+static thread_local bool s_RecordScopes = false;
+static thread_local uint32_t s_ScopeDepth = 0;
+static thread_local std::vector<ScopeTimer::Record> s_ScopeRecords;
+
+ScopeTimer::ScopeTimer(const char *name)
+	: m_Name(name), m_Start(s_RecordScopes ? now_ns() : 0)
+{
+	s_ScopeDepth++;
+}
+
+ScopeTimer::~ScopeTimer()
+{
+	s_ScopeDepth--;
+	// bounded in case nobody takes the records
+	if (s_RecordScopes && s_ScopeRecords.size() < 4096) s_ScopeRecords.push_back({ m_Name, s_ScopeDepth, m_Start, now_ns() });
+}
+
+void ScopeTimer::set_recording(bool record)
+{
+	s_RecordScopes = record;
+	s_ScopeRecords.clear();
+}
+
+void ScopeTimer::take_records(std::vector<Record> &records)
+{
+	records.swap(s_ScopeRecords);
+	s_ScopeRecords.clear();
+}
+
+int64_t ScopeTimer::now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
@@ -3,6 +3,8 @@
 #include <spdlog/fmt/ostr.h>
 #include <spdlog/spdlog.h>
 
+#include <atomic>
+
 #define ATL_PROFILE
 
 #ifdef ATL_PROFILE 
@@ -29,6 +31,14 @@ public:
 
 	inline static std::ostringstream &get_ostream() { return s_OStream; };
 
+	// messages per second a single trace to warn call site may log, the rest is counted and reported with the next one,
+	// 0 disables. errors and assertions are never limited
+	static void set_rate_limit(uint32_t messagesPerSecond);
+	static uint32_t get_rate_limit();
+
+	// drains the async queue and stops the logging thread, only for right before the process ends
+	static void shutdown();
+
 private:
 	static void init();
 
@@ -37,15 +47,65 @@ private:
 	static std::ostringstream s_OStream;
 };
 
-#define CORE_TRACE(...) ::Logger::get_core_logger()->trace(__VA_ARGS__)
-#define CORE_INFO(...) ::Logger::get_core_logger()->info(__VA_ARGS__)
-#define CORE_WARN(...) ::Logger::get_core_logger()->warn(__VA_ARGS__)
-#define CORE_ERROR(...) ::Logger::get_core_logger()->error(__VA_ARGS__)
+// rate limit state of one logging call site, a warning in a per frame path costs an atomic check once it's limited
+class LogSite {
+public:
+	// suppressed is set to the number of messages dropped since the last one that got through
+	bool allow(uint32_t &suppressed);
+
+private:
+	std::atomic<int64_t> m_WindowStart{ 0 };
+	std::atomic<uint32_t> m_Count{ 0 };
+	std::atomic<uint32_t> m_Suppressed{ 0 };
+};
+
+#define ATL_LOG(logger, level, ...) do {																		\
+	static ::LogSite atlLogSite;																				\
+	uint32_t atlSuppressed = 0;																					\
+	if (atlLogSite.allow(atlSuppressed)) {																		\
+		if (atlSuppressed) logger->level("{} messages suppressed at {}:{}", atlSuppressed, __FILE__, __LINE__);	\
+		logger->level(__VA_ARGS__);																				\
+	}																											\
+} while (0)
+
+// errors always get through, a burst of them is what the log is read for
+#define ATL_LOG_UNLIMITED(logger, level, ...) logger->level(__VA_ARGS__)
+
+// levels below this are compiled out, 0 trace, 1 debug, 2 info, 3 warn, 4 error
+#ifndef ATL_LOG_LEVEL
+#ifdef NDEBUG
+#define ATL_LOG_LEVEL 2
+#else
+#define ATL_LOG_LEVEL 0
+#endif
+#endif
+
+#if ATL_LOG_LEVEL <= 0
+#define CORE_TRACE(...) ATL_LOG(::Logger::get_core_logger(), trace, __VA_ARGS__)
+#define TRACE(...) ATL_LOG(::Logger::get_client_logger(), trace, __VA_ARGS__)
+#else
+#define CORE_TRACE(...) ((void)0)
+#define TRACE(...) ((void)0)
+#endif
 
-#define TRACE(...) ::Logger::get_client_logger()->trace(__VA_ARGS__)
-#define INFO(...) ::Logger::get_client_logger()->info(__VA_ARGS__)
-#define WARN(...) ::Logger::get_client_logger()->warn(__VA_ARGS__)
-#define ERROR(...) ::Logger::get_client_logger()->error(__VA_ARGS__)
+#if ATL_LOG_LEVEL <= 2
+#define CORE_INFO(...) ATL_LOG(::Logger::get_core_logger(), info, __VA_ARGS__)
+#define INFO(...) ATL_LOG(::Logger::get_client_logger(), info, __VA_ARGS__)
+#else
+#define CORE_INFO(...) ((void)0)
+#define INFO(...) ((void)0)
+#endif
+
+#if ATL_LOG_LEVEL <= 3
+#define CORE_WARN(...) ATL_LOG(::Logger::get_core_logger(), warn, __VA_ARGS__)
+#define WARN(...) ATL_LOG(::Logger::get_client_logger(), warn, __VA_ARGS__)
+#else
+#define CORE_WARN(...) ((void)0)
+#define WARN(...) ((void)0)
+#endif
+
+#define CORE_ERROR(...) ATL_LOG_UNLIMITED(::Logger::get_core_logger(), error, __VA_ARGS__)
+#define ERROR(...) ATL_LOG_UNLIMITED(::Logger::get_client_logger(), error, __VA_ARGS__)
 
 #ifdef WIN32
 #define DBREAK() __debugbreak()
@@ -54,20 +114,54 @@ private:
 #endif
 
 #ifndef NDEBUG
-#define CORE_ASSERT(x, ...) { if(!(x)) { CORE_ERROR("Assertion Failed:"); CORE_ERROR(__VA_ARGS__); DBREAK(); }}
-#define ASSERT(x, ...) { if(!(x)) { ERROR("Assertion Failed: {0}", __VA_ARGS__); DBREAK(); }}
+// the message has to leave the async queue before the process goes down
+#define CORE_ASSERT(x, ...) { if(!(x)) { CORE_ERROR("Assertion Failed:"); CORE_ERROR(__VA_ARGS__); ::Logger::shutdown(); DBREAK(); }}
+#define ASSERT(x, ...) { if(!(x)) { ERROR("Assertion Failed: {0}", __VA_ARGS__); ::Logger::shutdown(); DBREAK(); }}
 #else
 #define CORE_ASSERT(x, ...)
 #define ASSERT(x, ...)
 #endif
 
+// CPU scope timer behind ATL_EVENT, the frame statistics use it to name the scopes of slow frames
+class ScopeTimer {
+public:
+	struct Record {
+		const char *name;
+		uint32_t depth;
+		int64_t startNs;
+		int64_t endNs;
+	};
+
+	ScopeTimer(const char *name);
+	~ScopeTimer();
+
+	ScopeTimer(const ScopeTimer &) = delete;
+	void operator=(const ScopeTimer &) = delete;
+
+	// only threads that enabled recording pay for more than the depth counter
+	static void set_recording(bool record);
+	static void take_records(std::vector<Record> &records);
+	static int64_t now_ns();
+
+private:
+	const char *m_Name;
+	int64_t m_Start;
+};
+
+// ATL_EVENT names are string literals, an empty one falls back to the function name
+inline const char *atl_event_name(const char *name, const char *function) { return name[0] ? name : function; }
+
+#define ATL_CONCAT_IMPL(a, b) a##b
+#define ATL_CONCAT(a, b) ATL_CONCAT_IMPL(a, b)
+
+// expands to several declarations like OPTICK_EVENT itself, only use it at block scope and never as the body of an
+// unbraced if or for, there the ScopeTimer would run unconditionally
 #ifdef ATL_PROFILE
-#define ATL_EVENT(...) OPTICK_EVENT(__VA_ARGS__)
+#define ATL_EVENT(...) OPTICK_EVENT(__VA_ARGS__); ::ScopeTimer ATL_CONCAT(atlScopeTimer, __LINE__)(atl_event_name(__VA_ARGS__ "", __FUNCTION__))
 #define ATL_FRAME(...) OPTICK_FRAME(__VA_ARGS__)
 #else
 #define ATL_EVENT(...)
 #define ATL_FRAME(...)
-#define ATL_GPU_EVENT(...)
 #define ATL_GPU_INIT_VULKAN(...)
 #endif
 
@@ -3,45 +3,38 @@
 
 #include "RenderApi.h"
 #include "Render2D.h"
+#include "Profiler.h"
 
-#define PI 3.1415926535
+#include "physarum.h"
+#include "physarum_cpu.h"
+#include "bench.h"
 
 using namespace Atlas;
 
-struct Agent {
-	glm::ivec4 speciesMask;
-	glm::vec2 pos;
-	float angle;
-	int index;
-};
-
-struct SimSettings {
-	glm::vec4 color;
-	float moveSpeed;
-	float turnSpeed;
-	float sensorAngle;
-	float sensorDistance;
-	float sensorSize;
-	float randomStrength;
-};
-
-struct BlurSettings {
-	float evaporationSpeed;
-	float difuseSpeed;
-	int kernelSize;
-};
-
-struct GlobalSettings {
-	SimSettings sim;
-	BlurSettings blur;
-};
-
 class SimulationLayer : public Atlas::Layer {
 
-	Buffer agents;
+	Buffer agentPositions;
+	Buffer agentStates;
+	Buffer simBuffer;
+	Buffer blurBuffer;
 	Texture2D img;
-	Shader agentShader;
-	Shader blurShader;
+	Buffer summedArea;
+	Shader summedAreaShader;
+	ShaderVariantCache agentShaders;
+	ShaderVariantCache blurShaders;
+
+	// kernel/sensor sizes up to this get a variant with the size folded into the shader
+	static constexpr int maxSpecializedSize = 3;
+
+	// compare steps both backends and checks the GPU step against the CPU step from the same state every few steps
+	enum class Backend { GPU, CPU, COMPARE };
+	Backend backend = Backend::GPU;
+	PhysarumCpu cpuSim;
+	bool cpuTrailDirty = false;
+	int compareInterval = 30;
+	int stepsSinceCompare = 0;
+	PhysarumDivergence divergence{};
+	bool hasDivergence = false;
 
 	GlobalSettings settings;
 
@@ -53,69 +46,156 @@ class SimulationLayer : public Atlas::Layer {
 	OrthographicCameraController controller = OrthographicCameraController();
 
 	void reset_settings() {
-		//3
-		//2
-		//4
-		settings.sim.moveSpeed = 0.5f; //1
-		settings.sim.turnSpeed = 0.1f; //1.369
-		settings.sim.sensorAngle = 0.2f; //0.39
-		settings.sim.sensorDistance = 20.f; //20
-		settings.sim.sensorSize = 2.f; //20
-		settings.sim.randomStrength = 1.f;
-		settings.sim.color = glm::vec4(1, 1, 1, 1);
-
-		settings.blur.difuseSpeed = 0.1f; //0.1
-		settings.blur.evaporationSpeed = 0.01f; //0.01
-		settings.blur.kernelSize = 1;
+		default_settings(settings);
 	}
 
 	void init_sim() {
 		img = Texture2D::rgba(imgSize, imgSize, filter);
 
-		std::vector<Agent> agentsData(agentCount, Agent{});
+		Agents agentsData = spawn_agents(agentCount, imgSize, nSpecies);
 
-		for (auto &agent : agentsData) {
-			//agent.pos = Random::get<glm::vec2>(0, imgSize);
-			agent.pos = glm::vec2(imgSize / 2, imgSize / 2);
-			agent.angle = Random::get<float>(0.f, 2.f * PI);
-			agent.index = 0;
+		agentPositions = Buffer::create(BufferType::STORAGE, agentsData.positions.data(), agentsData.positions.size() * sizeof(glm::vec2));
+		agentStates = Buffer::create(BufferType::STORAGE, agentsData.states.data(), agentsData.states.size() * sizeof(uint32_t));
 
-			int species = Random::get<int>(0, nSpecies - 1);
-			agent.speciesMask[species] = 1;
-		}
+		if (backend != Backend::GPU) cpuSim.init(std::move(agentsData), imgSize);
+		hasDivergence = false;
 
-		agents = Buffer::create(BufferType::STORAGE, agentsData.data(), agentsData.size() * sizeof(Agent));
+		simBuffer = Buffer::storage(settings.sim);
+		blurBuffer = Buffer::storage(settings.blur);
+	}
+
+	Agents read_gpu_agents() {
+		memory_barrier(Barrier::ALL);
+		std::vector<uint8_t> positions = agentPositions.get_data();
+		std::vector<uint8_t> states = agentStates.get_data();
+
+		Agents result;
+		result.positions.resize(positions.size() / sizeof(glm::vec2));
+		result.states.resize(states.size() / sizeof(uint32_t));
+		std::memcpy(result.positions.data(), positions.data(), result.positions.size() * sizeof(glm::vec2));
+		std::memcpy(result.states.data(), states.data(), result.states.size() * sizeof(uint32_t));
+		return result;
+	}
+
+	void upload_cpu_state() {
+		const Agents &cpuAgents = cpuSim.get_agents();
+		agentPositions.set_data(0, cpuAgents.positions.data(), cpuAgents.positions.size() * sizeof(glm::vec2));
+		agentStates.set_data(0, cpuAgents.states.data(), cpuAgents.states.size() * sizeof(uint32_t));
+		img.fill(cpuSim.get_trail().data(), cpuSim.get_trail().size());
+	}
+
+	// the running simulation moves over to the other backend instead of restarting
+	void set_backend(Backend next) {
+		if (next == backend) return;
 
-		agentShader.bind("Agents", agents);
-		agentShader.bind("outImg", img, TextureUsage::WRITE);
+		if (backend == Backend::GPU) {
+			Agents gpuAgents = read_gpu_agents();
+			std::vector<uint8_t> trail = img.get_data();
+			cpuSim.init(gpuAgents, img.width());
+			cpuSim.set_state(gpuAgents, Span<const uint8_t>(trail));
+		}
+		else if (backend == Backend::CPU) {
+			upload_cpu_state();
+		}
 
-		blurShader.bind("img", img, TextureUsage::READ | TextureUsage::WRITE);
+		if (next == Backend::GPU) cpuSim = PhysarumCpu();
 
+		backend = next;
+		stepsSinceCompare = 0;
+		hasDivergence = false;
+	}
 
-		Buffer sim = Buffer::storage(settings.sim);
-		agentShader.bind("settingsBuffer", sim);
+	void step_cpu() {
+		cpuSim.step(settings);
+		cpuTrailDirty = true;
+	}
 
-		Buffer blur = Buffer::storage(settings.blur);
-		blurShader.bind("settingsBuffer", blur);
+	// returns the variant specialized for size if it finished compiling, the generic shader otherwise
+	Shader &select_variant(ShaderVariantCache &cache, const std::string &define, int size) {
+		if (size >= 0 && size <= maxSpecializedSize) {
+			Shader &variant = cache.get({ { define, std::to_string(size) } });
+			if (variant.is_ready()) return variant;
+		}
+		return cache.get();
 	}
 
 	void on_attach() override {
 		controller.set_camera(0, 1, 0, 1);
 		Render2D::init();
 
-		agentShader = Shader::load_comp("assets/shaders/agents.comp");
-		blurShader = Shader::load_comp("assets/shaders/blur.comp");
+		agentShaders = agent_shader_variants(true);
+		blurShaders = ShaderVariantCache::comp("assets/shaders/blur.comp", true);
+		summedAreaShader = Shader::load_comp("assets/shaders/summed_area.comp", true);
 
 		reset_settings();
 		init_sim();
 	}
 
-	void on_update(Timestep ts) override {
+	// one simulation step per tick, independent of the frame rate
+	void on_fixed_update(Timestep ts) override {
 
+		if (backend == Backend::CPU) {
+			step_cpu();
+			return;
+		}
 
+		Shader &agentShader = select_variant(agentShaders, "SENSOR_SIZE", int(settings.sim.sensorSize / 2));
+		Shader &blurShader = select_variant(blurShaders, "KERNEL_SIZE", settings.blur.kernelSize);
+
+		// large sensors read the trail through a summed-area table built at the start of every step
+		bool useSummedArea = int(settings.sim.sensorSize / 2) >= SUMMED_AREA_MIN_SIZE;
+
+		// keep presenting the empty trail map until the shaders finished compiling
+		if (agentShader.is_ready() && blurShader.is_ready() && (!useSummedArea || summedAreaShader.is_ready())) {
+			// both sides start the checked step from the CPU state
+			bool check = backend == Backend::COMPARE && ++stepsSinceCompare >= compareInterval;
+			if (check) {
+				upload_cpu_state();
+				stepsSinceCompare = 0;
+			}
+
+			agentShader.bind("AgentPositions", agentPositions);
+			agentShader.bind("AgentStates", agentStates);
+			agentShader.bind("outImg", img, TextureUsage::WRITE);
+			agentShader.bind("settingsBuffer", simBuffer);
+
+			if (useSummedArea) {
+				ATL_GPU_EVENT("summed area");
+				build_summed_area(summedAreaShader, img, summedArea);
+				agentShader.bind("SummedArea", summedArea);
+			}
+
+			blurShader.bind("img", img, TextureUsage::READ | TextureUsage::WRITE);
+			blurShader.bind("settingsBuffer", blurBuffer);
+
+			{
+				ATL_GPU_EVENT("agents");
+				Shader::dispatch(agentShader, (agentCount + 1023) / 1024, 1, 1);
+			}
+			{
+				ATL_GPU_EVENT("blur");
+				Shader::dispatch(blurShader, (img.width() + 31) / 32, img.height() / 32, 1);
+			}
+
+			if (backend == Backend::COMPARE) {
+				cpuSim.step(settings);
+
+				if (check) {
+					Agents gpuAgents = read_gpu_agents();
+					std::vector<uint8_t> gpuTrail = img.get_data();
+					divergence = cpuSim.compare(gpuAgents, Span<const uint8_t>(gpuTrail));
+					hasDivergence = true;
+				}
+			}
+		}
+	}
 
-		Shader::dispatch(agentShader, (agentCount + 1023) / 1024, 1, 1);
-		Shader::dispatch(blurShader, (img.width() + 31) / 32, img.height() / 32, 1);
+	void on_update(Timestep ts) override {
+		// the CPU trail is uploaded once per frame, however many steps ran
+		if (backend == Backend::CPU && cpuTrailDirty) {
+			img.fill(cpuSim.get_trail().data(), cpuSim.get_trail().size());
+			cpuTrailDirty = false;
+		}
 
 		controller.on_update(ts);
 		Render2D::set_camera(controller.get_camera());
@@ -129,6 +209,8 @@ class SimulationLayer : public Atlas::Layer {
 
 	void on_imgui() override {
 		show_settings();
+		Profiler::show_gpu_timeline();
+		Profiler::show_frame_statistics();
 	}
 
 	void show_settings() {
@@ -143,10 +225,28 @@ class SimulationLayer : public Atlas::Layer {
 		ImGui::Begin("Settings");
 
 		ImGui::Text("Simulation");
+
+		int simRate = (int)std::round(1.0f / Application::get_fixed_timestep());
+		if (ImGui::DragInt("steps per second", &simRate, 1, 1, 1000)) Application::set_fixed_timestep(1.0f / std::max(simRate, 1));
+		ImGui::Text("steps this frame: %u, dropped: %llu", Application::get_fixed_steps(), (unsigned long long)Application::get_dropped_fixed_steps());
 		ImGui::DragInt("resolution", &imgSize, 32, 0, 3840);
 		ImGui::DragInt("agents", &agentCount, 128, 0, 100000000);
 		ImGui::DragInt("species", &nSpecies, 1, 1, 3);
 
+		const char *backends[] = { "GPU", "CPU", "compare" };
+		int backendIndex = (int)backend;
+		if (ImGui::Combo("backend", &backendIndex, backends, 3)) set_backend((Backend)backendIndex);
+
+		if (backend != Backend::GPU) ImGui::Text("CPU blur: %s", PhysarumCpu::has_avx2() ? "AVX2" : "scalar");
+		if (backend == Backend::COMPARE) {
+			ImGui::DragInt("compare every", &compareInterval, 1, 1, 1000);
+			if (hasDivergence) {
+				ImGui::Text("step %llu: %u of %u agents diverged", (unsigned long long)divergence.step, divergence.divergedAgents, divergence.agents);
+				ImGui::Text("position error mean %.4f max %.4f, angle error max %.4f", divergence.meanPositionError, divergence.maxPositionError, divergence.maxAngleError);
+				ImGui::Text("%u of %u texels differ, error mean %.4f max %u", divergence.differingTexels, divergence.texels, divergence.meanTexelError, divergence.maxTexelError);
+			}
+		}
+
 		const char *filterName = "NONE";
 		if (filter == TextureFilter::LINEAR) filterName = "linear";
 		else if (filter == TextureFilter::NEAREST) filterName = "nearest";
@@ -202,13 +302,11 @@ class SimulationLayer : public Atlas::Layer {
 		}
 
 		if (updateSim) {
-			Buffer sim = Buffer::storage(settings.sim);
-			agentShader.bind("settingsBuffer", sim);
+			simBuffer = Buffer::storage(settings.sim);
 		}
 
 		if (updateBlur) {
-			Buffer blur = Buffer::storage(settings.blur);
-			blurShader.bind("settingsBuffer", blur);
+			blurBuffer = Buffer::storage(settings.blur);
 		}
 
 		ImGui::End();
@@ -219,8 +317,39 @@ class SimulationLayer : public Atlas::Layer {
 	}
 };
 
-int main() {
-	Atlas::Application app = Atlas::Application::default();
+int main(int argc, char **argv) {
+	Atlas::ApplicationCreateInfo info{};
+	info.width = 1600;
+	info.height = 900;
+	info.title = "Atlas Engine";
+
+	bool bench = false;
+	BenchOptions benchOptions{};
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--frame-stats" && i + 1 < argc) info.frameStatsPath = argv[++i];
+		else if (arg == "--headless") info.headless = true;
+		else if (arg == "--frames" && i + 1 < argc) info.frameCount = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--record" && i + 1 < argc) info.recordPath = argv[++i];
+		else if (arg == "--replay" && i + 1 < argc) info.replayPath = argv[++i];
+		else if (arg == "--bench") bench = true;
+		else if (arg == "--bench-frames" && i + 1 < argc) benchOptions.frames = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--bench-filter" && i + 1 < argc) benchOptions.filter = argv[++i];
+		else if (arg == "--bench-out" && i + 1 < argc) benchOptions.outputPath = argv[++i];
+		else if (arg == "--bench-baseline" && i + 1 < argc) benchOptions.baselinePath = argv[++i];
+		else if (arg == "--bench-tolerance" && i + 1 < argc) benchOptions.tolerance = std::stof(argv[++i]);
+	}
+
+	Atlas::Application app(info);
+
+	if (bench) {
+		auto benchLayer = make_ref<BenchLayer>(benchOptions);
+		app.push_layer(benchLayer);
+		app.run();
+		return benchLayer->has_regressions() ? 1 : 0;
+	}
+
 	app.push_layer(make_ref<SimulationLayer>());
 	app.run();
 
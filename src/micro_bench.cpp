@@ -0,0 +1,277 @@
+// CPU microbenchmarks of engine hot paths, runs against a headless context and reports ns/op and allocations/op
+// --cpu-only skips the context and the benchmarks that need it, for machines without a GL driver
+
+#include "application.h"
+#include "RenderApi.h"
+#include "Render2D.h"
+#include "EventQueue.h"
+#include "physarum_cpu.h"
+
+#include <new>
+
+using namespace Atlas;
+
+// every allocation of the process goes through these. the counter is per thread and the benchmarks read the one of the
+// thread running their loop, the async logger and the job system's workers allocate on their own and would only add noise
+static thread_local uint64_t s_Allocations = 0;
+
+void *operator new(size_t size)
+{
+	s_Allocations++;
+	if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+	s_Allocations++;
+	if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+// results are folded into this so the compiler can't drop the measured work
+static volatile uint64_t s_Sink = 0;
+
+template<typename T>
+inline void keep(const T &value)
+{
+	uint64_t bits = 0;
+	std::memcpy(&bits, &value, std::min(sizeof(T), sizeof(bits)));
+	s_Sink = s_Sink + bits;
+}
+
+struct MicroResult {
+	std::string name;
+	uint64_t iterations = 0;
+	double nsPerOp = 0;
+	double allocsPerOp = 0;
+};
+
+struct MicroOptions {
+	std::string filter;
+	double minTimeMs = 100;
+	uint32_t repetitions = 5;
+	bool cpuOnly = false;
+};
+
+static MicroOptions s_Options;
+static std::vector<MicroResult> s_Results;
+
+// doubles the iteration count until a run takes minTimeMs, then keeps the fastest of a few repetitions
+template<typename F>
+static void measure(const std::string &name, F &&op)
+{
+	if (!s_Options.filter.empty() && name.find(s_Options.filter) == std::string::npos) return;
+
+	auto run = [&](uint64_t iterations, uint64_t &allocations) {
+		uint64_t allocStart = s_Allocations;
+		int64_t start = ScopeTimer::now_ns();
+		for (uint64_t i = 0; i < iterations; i++) op(i);
+		int64_t elapsed = ScopeTimer::now_ns() - start;
+		allocations = s_Allocations - allocStart;
+		return (double)elapsed;
+	};
+
+	uint64_t allocations = 0;
+	uint64_t iterations = 1;
+	while (run(iterations, allocations) < s_Options.minTimeMs * 1e6 && iterations < (1ull << 40)) iterations *= 2;
+
+	MicroResult result{};
+	result.name = name;
+	result.iterations = iterations;
+	result.nsPerOp = std::numeric_limits<double>::max();
+
+	for (uint32_t i = 0; i < s_Options.repetitions; i++) {
+		double ns = run(iterations, allocations);
+		result.nsPerOp = std::min(result.nsPerOp, ns / iterations);
+		result.allocsPerOp = (double)allocations / iterations;
+	}
+
+	std::cout << "{\"name\":\"" << result.name << "\""
+		<< ",\"iterations\":" << result.iterations
+		<< ",\"ns_per_op\":" << result.nsPerOp
+		<< ",\"allocs_per_op\":" << result.allocsPerOp << "}" << std::endl;
+	s_Results.push_back(result);
+}
+
+static std::vector<Event> make_events()
+{
+	std::vector<Event> events;
+	for (int i = 0; i < 64; i++) {
+		switch (i % 4) {
+		case 0: events.push_back(Event(MouseMovedEvent{ (float)i, (float)i })); break;
+		case 1: events.push_back(Event(KeyPressedEvent{ 65 + i % 26, 0 })); break;
+		case 2: events.push_back(Event(MouseScrolledEvent{ 0.0f, 1.0f })); break;
+		case 3: events.push_back(Event(WindowResizedEvent{ 800, 600 })); break;
+		}
+	}
+	return events;
+}
+
+static void bench_events()
+{
+	auto events = make_events();
+
+	measure("Event::get_type", [&](uint64_t i) {
+		keep(events[i & 63].get_type());
+	});
+
+	measure("EventDispatcher::dispatch", [&](uint64_t i) {
+		Event &e = events[i & 63];
+		e.handled = false;
+		EventDispatcher(e)
+			.dispatch<MouseMovedEvent>([](MouseMovedEvent &m) { keep(m.mouseX); return false; })
+			.dispatch<WindowResizedEvent>([](WindowResizedEvent &w) { keep(w.width); return false; })
+			.dispatch<ViewportResizedEvent>([](ViewportResizedEvent &v) { keep(v.width); return false; });
+		keep(e.handled);
+	});
+
+	EventQueue queue;
+	measure("EventQueue::push/drain 64", [&](uint64_t) {
+		for (auto &e : events) queue.push(e);
+		queue.drain([](Event &e) { keep(e.handled); });
+	});
+}
+
+static void bench_textures()
+{
+	std::vector<Texture2D> textures;
+	for (int i = 0; i < 8; i++) textures.push_back(Texture2D::rgba(4, 4, TextureFilter::NEAREST));
+
+	measure("Texture2D::bind/cached", [&](uint64_t i) {
+		Texture2D::bind(textures[0], 0);
+	});
+
+	measure("Texture2D::bind/changing", [&](uint64_t i) {
+		Texture2D::bind(textures[i & 7], 0);
+	});
+
+	// Render2D::rect looks the texture up in the batch's slots before writing the quad
+	Render::begin(Application::get_viewport_color());
+	Render2D::set_view_proj(glm::mat4(1.0f));
+
+	measure("Render2D::rect/push_texture", [&](uint64_t i) {
+		Render2D::rect({ 0, 0 }, { 0.1f, 0.1f }, textures[i & 7]);
+	});
+
+	measure("Render2D::rect/color", [&](uint64_t i) {
+		Render2D::rect({ 0, 0 }, { 0.1f, 0.1f }, RGBA((uint8_t)i));
+	});
+
+	Render2D::flush();
+	Render::end();
+	Render::wait_idle();
+}
+
+struct MicroVertex {
+	glm::vec3 pos;
+	glm::vec2 uv;
+	glm::vec4 color;
+};
+
+static void bench_types()
+{
+	measure("Random::get<int>", [](uint64_t) { keep(Random::get<int>()); });
+	measure("Random::get<int>(min, max)", [](uint64_t) { keep(Random::get<int>(0, 99)); });
+	measure("Random::get<float>(min, max)", [](uint64_t) { keep(Random::get<float>(0.0f, 1.0f)); });
+	measure("Random::get<uint8_t>", [](uint64_t) { keep(Random::get<uint8_t>()); });
+
+	std::vector<uint8_t> bytes(1 << 20);
+	measure("Random::fill<uint8_t>/1M", [&](uint64_t) {
+		Random::fill(Span<uint8_t>(bytes), (uint8_t)0, (uint8_t)255);
+		keep(bytes[0]);
+	});
+
+	measure("RGBA::normalized", [](uint64_t i) {
+		RGBA color((uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16), 255);
+		keep(color.normalized().x);
+	});
+
+	measure("VertexLayout::from", [](uint64_t) {
+		VertexLayout layout = VertexLayout::from(&MicroVertex::pos, &MicroVertex::uv, &MicroVertex::color);
+		keep(layout.is_init());
+	});
+}
+
+static void bench_jobs()
+{
+	std::vector<float> values(1 << 20, 1.0f);
+
+	measure("Jobs::run/wait", [](uint64_t) {
+		Jobs::Counter counter;
+		Jobs::run([]() { keep(1); }, &counter);
+		Jobs::wait(counter);
+	});
+
+	measure("Jobs::parallel_for/1M", [&](uint64_t) {
+		Jobs::parallel_for_range(0, values.size(), 0, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) values[i] = values[i] * 0.5f + 0.5f;
+		});
+		keep(values[0]);
+	});
+}
+
+static void bench_physarum()
+{
+	GlobalSettings settings;
+	default_settings(settings);
+
+	PhysarumCpu sim;
+	sim.init(spawn_agents(50000, 640, 3), 640);
+
+	measure("PhysarumCpu::step/50K", [&](uint64_t) {
+		sim.step(settings);
+		keep(sim.get_steps());
+	});
+}
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--filter" && i + 1 < argc) s_Options.filter = argv[++i];
+		else if (arg == "--min-time" && i + 1 < argc) s_Options.minTimeMs = std::stod(argv[++i]);
+		else if (arg == "--repetitions" && i + 1 < argc) s_Options.repetitions = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--cpu-only") s_Options.cpuOnly = true;
+	}
+
+	// logging and profiling would be part of every measurement
+	Logger::get_core_logger()->set_level(spdlog::level::warn);
+	ScopeTimer::set_recording(false);
+
+	// sets up only what the Application would for the GL-free benchmarks, PhysarumCpu needs the job system
+	if (s_Options.cpuOnly) {
+		Random::init();
+		Jobs::init();
+
+		bench_events();
+		bench_types();
+		bench_jobs();
+		bench_physarum();
+
+		Jobs::shutdown();
+		return 0;
+	}
+
+	ApplicationCreateInfo info{};
+	info.title = "Atlas micro benchmarks";
+	info.width = 256;
+	info.height = 256;
+	info.headless = true;
+
+	Application app(info);
+	Render2D::init();
+
+	bench_events();
+	bench_types();
+	bench_jobs();
+	bench_physarum();
+	bench_textures();
+
+	return 0;
+}
@@ -16,6 +16,7 @@
 #include <unordered_set>
 #include <type_traits>
 #include <thread>
+#include <chrono>
 #include <random>
 
 #include <functional>
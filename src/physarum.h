@@ -0,0 +1,127 @@
+#pragma once
+
+#include "atl_types.h"
+#include "RenderApi.h"
+
+// shared by the simulation layer and the benchmarks, layouts match agents.comp and blur.comp
+
+#define PI 3.1415926535
+
+// agents are stored as two arrays, agents.comp reads them from its AgentPositions and AgentStates buffers,
+// 12 bytes per agent where a struct with an ivec4 species mask took 32
+struct Agents {
+	std::vector<glm::vec2> positions;
+	std::vector<uint32_t> states;
+
+	inline size_t size() const { return positions.size(); }
+};
+
+// a state packs the heading as a 16 bit fraction of a turn with the species index in the two bits above it,
+// pack_state, unpack_angle and unpack_species of agents.comp do the same
+constexpr uint32_t AGENT_ANGLE_STEPS = 1 << 16;
+constexpr uint32_t AGENT_SPECIES_SHIFT = 16;
+
+inline uint32_t pack_agent_state(float angle, uint32_t species)
+{
+	float turns = angle / (2.f * (float)PI);
+	turns -= std::floor(turns);
+	return ((uint32_t)(turns * AGENT_ANGLE_STEPS + 0.5f) & (AGENT_ANGLE_STEPS - 1)) | ((species & 3) << AGENT_SPECIES_SHIFT);
+}
+
+inline float unpack_agent_angle(uint32_t state)
+{
+	return (float)(state & (AGENT_ANGLE_STEPS - 1)) * (2.f * (float)PI / AGENT_ANGLE_STEPS);
+}
+
+inline uint32_t unpack_agent_species(uint32_t state)
+{
+	return (state >> AGENT_SPECIES_SHIFT) & 3;
+}
+
+struct SimSettings {
+	glm::vec4 color;
+	float moveSpeed;
+	float turnSpeed;
+	float sensorAngle;
+	float sensorDistance;
+	float sensorSize;
+	float randomStrength;
+};
+
+struct BlurSettings {
+	float evaporationSpeed;
+	float difuseSpeed;
+	int kernelSize;
+};
+
+struct GlobalSettings {
+	SimSettings sim;
+	BlurSettings blur;
+};
+
+inline void default_settings(GlobalSettings &settings)
+{
+	settings.sim.moveSpeed = 0.5f;
+	settings.sim.turnSpeed = 0.1f;
+	settings.sim.sensorAngle = 0.2f;
+	settings.sim.sensorDistance = 20.f;
+	settings.sim.sensorSize = 2.f;
+	settings.sim.randomStrength = 1.f;
+	settings.sim.color = glm::vec4(1, 1, 1, 1);
+
+	settings.blur.difuseSpeed = 0.1f;
+	settings.blur.evaporationSpeed = 0.01f;
+	settings.blur.kernelSize = 1;
+}
+
+// sensors of at least this half size sum the trail from a summed-area table in four fetches instead of sampling
+// every texel of the window, agents.comp gets it through agent_shader_variants
+constexpr int SUMMED_AREA_MIN_SIZE = 3;
+
+// variants of agents.comp, the shader switches to the table at the same size the host starts building it
+inline Atlas::ShaderVariantCache agent_shader_variants(bool async = false)
+{
+	Atlas::ShaderCreateInfo info{};
+	info.layout = Atlas::VertexLayout::empty();
+	info.async = async;
+	info.modules.push_back({ "assets/shaders/agents.comp", Atlas::ShaderType::COMPUTE });
+	info.defines = { { "SUMMED_AREA_MIN_SIZE", std::to_string(SUMMED_AREA_MIN_SIZE) } };
+	return Atlas::ShaderVariantCache(info);
+}
+
+// fills table from the trail map with summed_area.comp, agents.comp reads it through its SummedArea buffer
+inline void build_summed_area(Atlas::Shader &shader, const Atlas::Texture2D &trail, Atlas::Buffer &table)
+{
+	size_t size = (size_t)trail.width() * trail.height() * sizeof(glm::uvec4);
+	if (!table.is_init() || table.size() != size) table = Atlas::Buffer::create(Atlas::BufferType::STORAGE, nullptr, size);
+
+	shader.bind("img", trail, Atlas::TextureUsage::READ);
+	shader.bind("SummedArea", table);
+
+	// the rows read what the last blur wrote, the columns what the rows wrote and the agents the columns
+	Atlas::memory_barrier(Atlas::Barrier::ALL);
+	shader.set_int("direction", 0);
+	Atlas::Shader::dispatch(shader, trail.height(), 1, 1);
+
+	Atlas::memory_barrier(Atlas::Barrier::ALL);
+	shader.set_int("direction", 1);
+	Atlas::Shader::dispatch(shader, trail.width(), 1, 1);
+
+	Atlas::memory_barrier(Atlas::Barrier::ALL);
+}
+
+// every agent starts in the center of the trail map facing a random direction
+inline Agents spawn_agents(int count, int imgSize, int nSpecies)
+{
+	Agents agents;
+	agents.positions.assign(count, glm::vec2(imgSize / 2, imgSize / 2));
+	agents.states.resize(count);
+
+	Atlas::Random::generate(Span<uint32_t>(agents.states), [nSpecies](Atlas::Random::Generator &generator) {
+		float angle = generator.range(0.f, 2.f * (float)PI);
+		uint32_t species = (uint32_t)generator.range(0, nSpecies - 1);
+		return pack_agent_state(angle, species);
+	});
+
+	return agents;
+}
@@ -0,0 +1,499 @@
+#include "physarum_cpu.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PHYSARUM_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// only the AVX2 functions are compiled for it, everything else stays on the baseline instruction set
+#if defined(PHYSARUM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PHYSARUM_AVX2 __attribute__((target("avx2")))
+#else
+#define PHYSARUM_AVX2
+#endif
+
+// agents per move/deposit chunk and rows per blur chunk
+static constexpr size_t AGENT_GRAIN = 1 << 14;
+static constexpr size_t BLUR_GRAIN = 16;
+
+bool PhysarumCpu::has_avx2()
+{
+#if !defined(PHYSARUM_X86)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+
+	// the OS has to save the ymm registers too
+	__cpuid(info, 1);
+	bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+	if (!avx || (_xgetbv(0) & 6) != 6) return false;
+
+	__cpuidex(info, 7, 0);
+	return info[1] & (1 << 5);
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+void PhysarumCpu::init(Agents agents, uint32_t size)
+{
+	m_Agents = std::move(agents);
+	m_Size = size;
+	m_Steps = 0;
+
+	m_Trail.assign((size_t)size * size * 4, 0);
+	m_Blurred.assign(m_Trail.size(), 0);
+
+	uint32_t bands = Atlas::Jobs::get_thread_count() * 4;
+	m_BandRows = std::max(1u, (size + bands - 1) / bands);
+	m_BandCount = (size + m_BandRows - 1) / m_BandRows;
+
+	size_t chunks = (m_Agents.size() + AGENT_GRAIN - 1) / AGENT_GRAIN;
+	m_AgentBands.resize(m_Agents.size());
+	m_Order.resize(m_Agents.size());
+	m_ChunkOffsets.resize(chunks * m_BandCount);
+	m_BandStarts.resize(m_BandCount + 1);
+}
+
+void PhysarumCpu::set_state(const Agents &agents, Span<const uint8_t> trail)
+{
+	CORE_ASSERT(agents.size() == m_Agents.size() && trail.size() == m_Trail.size(), "PhysarumCpu::set_state: state of a simulation with a different size");
+
+	m_Agents.positions = agents.positions;
+	m_Agents.states = agents.states;
+	std::copy(trail.begin(), trail.end(), m_Trail.begin());
+}
+
+void PhysarumCpu::step(const GlobalSettings &settings)
+{
+	if (m_Size == 0) return;
+	ATL_EVENT();
+
+	if ((int)(settings.sim.sensorSize / 2) >= SUMMED_AREA_MIN_SIZE) build_summed_area();
+	move_agents(settings.sim);
+	deposit();
+	blur(settings.blur);
+	m_Steps++;
+}
+
+// the table summed_area.comp builds, sums wrap like the uints of the shader and window sums stay exact
+void PhysarumCpu::build_summed_area()
+{
+	ATL_EVENT();
+
+	const size_t stride = (size_t)m_Size * 4;
+	m_SummedArea.resize(m_Trail.size());
+
+	Atlas::Jobs::parallel_for_range(0, m_Size, BLUR_GRAIN, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++) {
+			const uint8_t *src = m_Trail.data() + y * stride;
+			uint32_t *dst = m_SummedArea.data() + y * stride;
+
+			uint32_t sum[4] = {};
+			for (size_t x = 0; x < stride; x += 4) {
+				for (size_t c = 0; c < 4; c++) {
+					sum[c] += src[x + c];
+					dst[x + c] = sum[c];
+				}
+			}
+		}
+	});
+
+	// columns in strips, every strip walks down the rows
+	Atlas::Jobs::parallel_for_range(0, stride, 1024, [&](size_t begin, size_t end) {
+		for (size_t y = 1; y < m_Size; y++) {
+			uint32_t *row = m_SummedArea.data() + y * stride;
+			const uint32_t *above = row - stride;
+			for (size_t i = begin; i < end; i++) row[i] += above[i];
+		}
+	});
+}
+
+// agents.comp, agents only read the trail here so every agent senses the trail of the previous step
+void PhysarumCpu::move_agents(const SimSettings &settings)
+{
+	ATL_EVENT();
+
+	const int size = (int)m_Size;
+	const uint8_t *trail = m_Trail.data();
+	const int sensorSize = (int)(settings.sensorSize / 2);
+	const bool useSummedArea = sensorSize >= SUMMED_AREA_MIN_SIZE;
+	const uint32_t *table = m_SummedArea.data();
+	const uint32_t bands = m_BandCount;
+
+	auto summed_area = [&](int x, int y, int channel) {
+		return x < 0 || y < 0 ? 0u : table[((size_t)y * size + x) * 4 + channel];
+	};
+
+	auto sense = [&](const glm::vec2 &pos, float heading, const glm::vec4 &weight, float angleOffset) {
+		float angle = heading + angleOffset;
+		int centerX = (int)(pos.x + std::cos(angle) * settings.sensorDistance);
+		int centerY = (int)(pos.y + std::sin(angle) * settings.sensorDistance);
+
+		// senseSummedArea, the window is clamped to the trail map and its sum scaled up to the full window
+		if (useSummedArea) {
+			int loX = std::clamp(centerX - sensorSize, 0, size - 1);
+			int loY = std::clamp(centerY - sensorSize, 0, size - 1);
+			int hiX = std::clamp(centerX + sensorSize, 0, size - 1);
+			int hiY = std::clamp(centerY + sensorSize, 0, size - 1);
+			float scale = (float)((2 * sensorSize + 1) * (2 * sensorSize + 1)) / (float)((hiX - loX + 1) * (hiY - loY + 1));
+
+			float sum = 0;
+			for (int c = 0; c < 4; c++) {
+				uint32_t value = summed_area(hiX, hiY, c) - summed_area(loX - 1, hiY, c) - summed_area(hiX, loY - 1, c) + summed_area(loX - 1, loY - 1, c);
+				sum += (float)value / 255.f * scale * weight[c];
+			}
+			return sum;
+		}
+
+		float sum = 0;
+		for (int offsetX = -sensorSize; offsetX <= sensorSize; offsetX++) {
+			int x = std::min(size - 1, std::max(0, centerX + offsetX));
+			for (int offsetY = -sensorSize; offsetY <= sensorSize; offsetY++) {
+				int y = std::min(size - 1, std::max(0, centerY + offsetY));
+
+				const uint8_t *texel = trail + ((size_t)y * size + x) * 4;
+				sum += texel[0] / 255.f * weight.x + texel[1] / 255.f * weight.y + texel[2] / 255.f * weight.z + texel[3] / 255.f * weight.w;
+			}
+		}
+		return sum;
+	};
+
+	Atlas::Jobs::parallel_for_range(0, m_Agents.size(), AGENT_GRAIN, [&](size_t begin, size_t end) {
+		uint32_t *counts = m_ChunkOffsets.data() + (begin / AGENT_GRAIN) * bands;
+		std::fill(counts, counts + bands, 0);
+
+		for (size_t i = begin; i < end; i++) {
+			glm::vec2 pos = m_Agents.positions[i];
+			float angle = unpack_agent_angle(m_Agents.states[i]);
+			uint32_t species = unpack_agent_species(m_Agents.states[i]);
+
+			// +1 for the own species, -1 for the others and the alpha
+			glm::vec4 weight = glm::vec4(-1.f);
+			weight[species] = 1.f;
+
+			uint32_t random = physarum_hash((uint32_t)(int)(pos.y * size + pos.x) + physarum_hash((uint32_t)i * 824941u));
+
+			float forward = sense(pos, angle, weight, 0);
+			float left = sense(pos, angle, weight, settings.sensorAngle);
+			float right = sense(pos, angle, weight, -settings.sensorAngle);
+
+			float steer = physarum_unit(physarum_hash(random)) * settings.randomStrength;
+
+			if (forward == 0 && right == 0 && left == 0) angle += (steer - 0.5f) * 2 * settings.turnSpeed;
+			else if (forward > left && forward > right) {}	// keeps its heading
+			else if (forward < left && forward < right) angle += (steer - 0.5f) * 2 * settings.turnSpeed;
+			else if (left > right) angle += steer * settings.turnSpeed;
+			else if (left < right) angle -= steer * settings.turnSpeed;
+			else angle += (steer - 0.5f) * 2 * settings.turnSpeed;
+
+			pos.x += settings.moveSpeed * std::cos(angle);
+			pos.y += settings.moveSpeed * std::sin(angle);
+
+			if (pos.x <= 0 || pos.x >= size || pos.y <= 0 || pos.y >= size) {
+				pos.x = std::min((float)(size - 1), std::max(0.f, pos.x));
+				pos.y = std::min((float)(size - 1), std::max(0.f, pos.y));
+				angle = physarum_unit(physarum_hash(random)) * 2 * (float)PI;
+			}
+
+			m_Agents.positions[i] = pos;
+			m_Agents.states[i] = pack_agent_state(angle, species);
+
+			uint16_t band = (uint16_t)((uint32_t)pos.y / m_BandRows);
+			m_AgentBands[i] = band;
+			counts[band]++;
+		}
+	});
+}
+
+// the imageStore at the end of agents.comp, sorted into bands so no two threads write the same texel
+void PhysarumCpu::deposit()
+{
+	ATL_EVENT();
+
+	const uint32_t bands = m_BandCount;
+	const size_t chunks = (m_Agents.size() + AGENT_GRAIN - 1) / AGENT_GRAIN;
+
+	// counts to offsets, band major so every band is one range of m_Order
+	uint32_t offset = 0;
+	for (uint32_t band = 0; band < bands; band++) {
+		m_BandStarts[band] = offset;
+		for (size_t chunk = 0; chunk < chunks; chunk++) {
+			uint32_t &slot = m_ChunkOffsets[chunk * bands + band];
+			uint32_t count = slot;
+			slot = offset;
+			offset += count;
+		}
+	}
+	m_BandStarts[bands] = offset;
+
+	Atlas::Jobs::parallel_for_range(0, m_Agents.size(), AGENT_GRAIN, [&](size_t begin, size_t end) {
+		uint32_t *offsets = m_ChunkOffsets.data() + (begin / AGENT_GRAIN) * bands;
+		for (size_t i = begin; i < end; i++) m_Order[offsets[m_AgentBands[i]]++] = (uint32_t)i;
+	});
+
+	uint8_t *trail = m_Trail.data();
+	Atlas::Jobs::parallel_for(0, bands, [&](size_t band) {
+		for (uint32_t k = m_BandStarts[band]; k < m_BandStarts[band + 1]; k++) {
+			uint32_t agent = m_Order[k];
+			const glm::vec2 &pos = m_Agents.positions[agent];
+			uint8_t *texel = trail + ((size_t)(int)pos.y * m_Size + (int)pos.x) * 4;
+
+			uint32_t species = unpack_agent_species(m_Agents.states[agent]);
+			texel[0] = species == 0 ? 255 : 0;
+			texel[1] = species == 1 ? 255 : 0;
+			texel[2] = species == 2 ? 255 : 0;
+			texel[3] = 255;
+		}
+	}, 1);
+}
+
+struct BlurArgs {
+	const uint8_t *src;
+	uint8_t *dst;
+	int size;
+	int kernel;
+	float scale;	// 0 when blur.comp's loop sums nothing
+	float difuse;
+	float evaporation;
+};
+
+// box sums along row y of every channel, texels outside the image count as zero like the out of bounds imageLoads of blur.comp
+static void row_sums(const BlurArgs &args, int y, float *padded, float *sums)
+{
+	const size_t stride = (size_t)args.size * 4;
+	const size_t border = (size_t)args.kernel * 4;
+	const uint8_t *row = args.src + y * stride;
+
+	std::fill(padded, padded + border, 0.f);
+	std::fill(padded + border + stride, padded + 2 * border + stride, 0.f);
+	for (size_t i = 0; i < stride; i++) padded[border + i] = row[i] / 255.f;
+
+	for (size_t i = 0; i < stride; i++) {
+		float sum = 0;
+		for (int d = 0; d <= 2 * args.kernel; d++) sum += padded[i + d * 4];
+		sums[i] = sum;
+	}
+}
+
+// sums count rows of horizontal sums and writes the diffused and evaporated row y
+static void finish_row(const BlurArgs &args, int y, const float *rows, int count, size_t stride)
+{
+	const uint8_t *src = args.src + y * stride;
+	uint8_t *dst = args.dst + y * stride;
+
+	for (size_t i = 0; i < stride; i++) {
+		if (i % 4 == 3) {
+			dst[i] = 255;
+			continue;
+		}
+
+		float sum = 0;
+		for (int r = 0; r < count; r++) sum += rows[r * stride + i];
+
+		float center = src[i] / 255.f;
+		float blurred = sum * args.scale / 9.f;
+		float value = center * (1.f - args.difuse) + blurred * args.difuse;
+		value = std::min(1.f, std::max(0.f, value - args.evaporation));
+		dst[i] = (uint8_t)(int)(value * 255.f + 0.5f);
+	}
+}
+
+#ifdef PHYSARUM_X86
+
+PHYSARUM_AVX2 static __m256 load_unorm8(const uint8_t *data)
+{
+	__m256i bytes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)data));
+	return _mm256_div_ps(_mm256_cvtepi32_ps(bytes), _mm256_set1_ps(255.f));
+}
+
+// same arithmetic as row_sums, two texels at a time
+PHYSARUM_AVX2 static void row_sums_avx2(const BlurArgs &args, int y, float *padded, float *sums)
+{
+	const size_t stride = (size_t)args.size * 4;
+	const size_t border = (size_t)args.kernel * 4;
+	const uint8_t *row = args.src + y * stride;
+
+	std::fill(padded, padded + border, 0.f);
+	std::fill(padded + border + stride, padded + 2 * border + stride, 0.f);
+
+	size_t i = 0;
+	for (; i + 8 <= stride; i += 8) _mm256_storeu_ps(padded + border + i, load_unorm8(row + i));
+	for (; i < stride; i++) padded[border + i] = row[i] / 255.f;
+
+	for (i = 0; i + 8 <= stride; i += 8) {
+		__m256 sum = _mm256_setzero_ps();
+		for (int d = 0; d <= 2 * args.kernel; d++) sum = _mm256_add_ps(sum, _mm256_loadu_ps(padded + i + d * 4));
+		_mm256_storeu_ps(sums + i, sum);
+	}
+	for (; i < stride; i++) {
+		float sum = 0;
+		for (int d = 0; d <= 2 * args.kernel; d++) sum += padded[i + d * 4];
+		sums[i] = sum;
+	}
+}
+
+PHYSARUM_AVX2 static void finish_row_avx2(const BlurArgs &args, int y, const float *rows, int count, size_t stride)
+{
+	const uint8_t *src = args.src + y * stride;
+	uint8_t *dst = args.dst + y * stride;
+
+	const __m256 scale = _mm256_set1_ps(args.scale);
+	const __m256 nine = _mm256_set1_ps(9.f);
+	const __m256 difuse = _mm256_set1_ps(args.difuse);
+	const __m256 keep = _mm256_set1_ps(1.f - args.difuse);
+	const __m256 evaporation = _mm256_set1_ps(args.evaporation);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 max = _mm256_set1_ps(255.f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256i opaque = _mm256_set1_epi32(255);
+
+	size_t i = 0;
+	for (; i + 8 <= stride; i += 8) {
+		__m256 sum = _mm256_setzero_ps();
+		for (int r = 0; r < count; r++) sum = _mm256_add_ps(sum, _mm256_loadu_ps(rows + r * stride + i));
+
+		__m256 center = load_unorm8(src + i);
+		__m256 blurred = _mm256_div_ps(_mm256_mul_ps(sum, scale), nine);
+		__m256 value = _mm256_add_ps(_mm256_mul_ps(center, keep), _mm256_mul_ps(blurred, difuse));
+		value = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_sub_ps(value, evaporation)));
+
+		__m256i bytes = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, max), half));
+		bytes = _mm256_blend_epi32(bytes, opaque, 0x88);
+
+		// packing works per 128 bit lane, each lane ends up with one texel in its low four bytes
+		bytes = _mm256_packs_epi32(bytes, bytes);
+		bytes = _mm256_packus_epi16(bytes, bytes);
+		uint32_t first = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+		uint32_t second = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+		std::memcpy(dst + i, &first, 4);
+		std::memcpy(dst + i + 4, &second, 4);
+	}
+
+	// an odd width leaves one texel
+	for (; i < stride; i++) {
+		if (i % 4 == 3) {
+			dst[i] = 255;
+			continue;
+		}
+
+		float sum = 0;
+		for (int r = 0; r < count; r++) sum += rows[r * stride + i];
+
+		float center = src[i] / 255.f;
+		float blurred = sum * args.scale / 9.f;
+		float value = center * (1.f - args.difuse) + blurred * args.difuse;
+		value = std::min(1.f, std::max(0.f, value - args.evaporation));
+		dst[i] = (uint8_t)(int)(value * 255.f + 0.5f);
+	}
+}
+
+#endif
+
+static void blur_rows(const BlurArgs &args, int begin, int end, bool avx2)
+{
+	const int size = args.size;
+	const int k = args.kernel;
+	const size_t stride = (size_t)size * 4;
+
+	// horizontal sums of every row the output rows reach
+	int first = std::max(0, begin - k);
+	int last = std::min(size, end + k);
+
+	thread_local std::vector<float> padded;
+	thread_local std::vector<float> sums;
+	padded.resize(stride + (size_t)k * 8);
+	sums.resize((size_t)(last - first) * stride);
+
+	for (int y = first; y < last; y++) {
+		float *out = sums.data() + (y - first) * stride;
+#ifdef PHYSARUM_X86
+		if (avx2) {
+			row_sums_avx2(args, y, padded.data(), out);
+			continue;
+		}
+#endif
+		row_sums(args, y, padded.data(), out);
+	}
+
+	for (int y = begin; y < end; y++) {
+		int top = std::max(0, y - k);
+		int bottom = std::min(size - 1, y + k);
+		const float *rows = sums.data() + (top - first) * stride;
+#ifdef PHYSARUM_X86
+		if (avx2) {
+			finish_row_avx2(args, y, rows, bottom - top + 1, stride);
+			continue;
+		}
+#endif
+		finish_row(args, y, rows, bottom - top + 1, stride);
+	}
+}
+
+// blur.comp, it blurs in place and its threads race on neighbouring texels, here every texel reads the trail before the blur
+void PhysarumCpu::blur(const BlurSettings &settings)
+{
+	ATL_EVENT();
+	static const bool avx2 = has_avx2();
+
+	BlurArgs args{};
+	args.src = m_Trail.data();
+	args.dst = m_Blurred.data();
+	args.size = (int)m_Size;
+	args.kernel = std::max(0, settings.kernelSize);
+	args.scale = settings.kernelSize >= 0 ? 1.f : 0.f;
+	args.difuse = settings.difuseSpeed;
+	args.evaporation = settings.evaporationSpeed;
+
+	Atlas::Jobs::parallel_for_range(0, m_Size, BLUR_GRAIN, [&](size_t begin, size_t end) {
+		blur_rows(args, (int)begin, (int)end, avx2);
+	});
+
+	std::swap(m_Trail, m_Blurred);
+}
+
+PhysarumDivergence PhysarumCpu::compare(const Agents &agents, Span<const uint8_t> trail) const
+{
+	CORE_ASSERT(agents.size() == m_Agents.size() && trail.size() == m_Trail.size(), "PhysarumCpu::compare: state of a simulation with a different size");
+	ATL_EVENT();
+
+	PhysarumDivergence result{};
+	result.step = m_Steps;
+	result.agents = (uint32_t)agents.size();
+	result.texels = m_Size * m_Size;
+
+	double positionError = 0;
+	for (size_t i = 0; i < agents.size(); i++) {
+		float error = glm::length(agents.positions[i] - m_Agents.positions[i]);
+		float angle = unpack_agent_angle(agents.states[i]) - unpack_agent_angle(m_Agents.states[i]);
+		float angleError = std::abs(std::remainder(angle, 2 * (float)PI));
+
+		positionError += error;
+		result.maxPositionError = std::max(result.maxPositionError, error);
+		result.maxAngleError = std::max(result.maxAngleError, angleError);
+		if (error > 0.5f) result.divergedAgents++;
+	}
+	if (agents.size()) result.meanPositionError = (float)(positionError / agents.size());
+
+	uint64_t texelError = 0;
+	for (size_t texel = 0; texel < result.texels; texel++) {
+		uint32_t maxError = 0;
+		for (size_t c = 0; c < 4; c++) {
+			uint32_t error = (uint32_t)std::abs((int)trail[texel * 4 + c] - (int)m_Trail[texel * 4 + c]);
+			texelError += error;
+			maxError = std::max(maxError, error);
+		}
+
+		if (maxError) result.differingTexels++;
+		result.maxTexelError = std::max(result.maxTexelError, maxError);
+	}
+	if (result.texels) result.meanTexelError = (float)((double)texelError / ((double)result.texels * 4));
+
+	return result;
+}
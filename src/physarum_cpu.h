@@ -0,0 +1,81 @@
+#pragma once
+
+#include "physarum.h"
+
+// CPU backend of the slime mould simulation, steps the same model as agents.comp followed by blur.comp
+// without a GL context, it's the reference the shaders are validated against
+
+// hash and uintToRange01 of common/hash.glsl, agents draw the same random numbers as on the GPU
+inline uint32_t physarum_hash(uint32_t state)
+{
+	state ^= 2747636419u;
+	state *= 2654435769u;
+	state ^= state >> 16;
+	state *= 2654435769u;
+	state ^= state >> 16;
+	state *= 2654435769u;
+	return state;
+}
+
+inline float physarum_unit(uint32_t state)
+{
+	return (float)state / 4294967295.f;
+}
+
+// how far a GPU step ended up from the CPU step that started from the same state
+struct PhysarumDivergence {
+	uint64_t step = 0;
+	uint32_t agents = 0;
+	uint32_t divergedAgents = 0;	// more than half a texel away from the reference
+	float meanPositionError = 0;
+	float maxPositionError = 0;
+	float maxAngleError = 0;
+
+	uint32_t texels = 0;
+	uint32_t differingTexels = 0;
+	float meanTexelError = 0;		// per channel, in 8 bit steps
+	uint32_t maxTexelError = 0;
+};
+
+class PhysarumCpu {
+public:
+	// trail is an rgba8 image of size x size texels with tightly packed rows, like the trail texture
+	void init(Agents agents, uint32_t size);
+	void set_state(const Agents &agents, Span<const uint8_t> trail);
+
+	// one agents.comp dispatch followed by one blur.comp dispatch
+	void step(const GlobalSettings &settings);
+
+	PhysarumDivergence compare(const Agents &agents, Span<const uint8_t> trail) const;
+
+	inline const Agents &get_agents() const { return m_Agents; }
+	inline const std::vector<uint8_t> &get_trail() const { return m_Trail; }
+	inline uint32_t get_size() const { return m_Size; }
+	inline uint64_t get_steps() const { return m_Steps; }
+	inline bool is_init() const { return m_Size != 0; }
+
+	// the blur runs on AVX2 where the CPU has it, both paths give the same bytes
+	static bool has_avx2();
+
+private:
+	void build_summed_area();
+	void move_agents(const SimSettings &settings);
+	void deposit();
+	void blur(const BlurSettings &settings);
+
+	Agents m_Agents;
+	std::vector<uint8_t> m_Trail;
+	std::vector<uint8_t> m_Blurred;
+	std::vector<uint32_t> m_SummedArea;	// only built for sensors of at least SUMMED_AREA_MIN_SIZE
+	uint32_t m_Size{ 0 };
+	uint64_t m_Steps{ 0 };
+
+	// deposits are sorted into bands of rows, every band is written by one thread in agent order
+	// so the texel of two agents landing on it is decided like in a sequential run
+	uint32_t m_BandCount{ 0 };
+	uint32_t m_BandRows{ 0 };
+	std::vector<uint16_t> m_AgentBands;
+	std::vector<uint32_t> m_ChunkOffsets;	// per chunk of agents and band, counts and then scatter offsets
+	std::vector<uint32_t> m_BandStarts;
+	std::vector<uint32_t> m_Order;
+};
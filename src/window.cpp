@@ -3,6 +3,12 @@
 #include <GLFW/glfw3.h>
 
 #include "application.h"
+#include "gl_utils.h"
+
+#ifdef ATLAS_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 namespace Atlas {
 
@@ -26,15 +32,18 @@ namespace Atlas {
 
 	void Window::set_vsync(bool enable)
 	{
+		if (m_Headless) return;
 		glfwSwapInterval(enable);
 	}
 
 	bool Window::is_key_pressed(KeyCode key) {
+		if (m_Headless) return false;
 		auto state = glfwGetKey(m_Window, (int)key);
 		return state == GLFW_PRESS || state == GLFW_REPEAT;
 	}
 
 	bool Window::is_mouse_button_pressed(int button) {
+		if (m_Headless) return false;
 		auto state = glfwGetMouseButton(m_Window, button);
 		return state == GLFW_PRESS;
 	}
@@ -46,6 +55,16 @@ namespace Atlas {
 
 	void Window::init(const WindowCreateInfo &info) {
 
+		m_StartTime = std::chrono::steady_clock::now();
+		m_Headless = info.headless;
+
+#ifdef ATLAS_HEADLESS_EGL
+		if (m_Headless) {
+			init_headless();
+			return;
+		}
+#endif
+
 		CORE_TRACE("Creating window {0} ({1}, {2})", m_Title, m_Width, m_Height);
 
 		if (!s_GLFWInitialized) {
@@ -62,14 +81,20 @@ namespace Atlas {
 		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE); //TODO: enable
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
+		// without egl the headless mode still needs a display, the window is just never shown
+		if (m_Headless) {
+			CORE_WARN("Window: built without ATLAS_HEADLESS_EGL, headless mode uses a hidden window");
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		}
+
 		m_Window = glfwCreateWindow((int)m_Width, (int)m_Height, m_Title.c_str(),
 			nullptr, nullptr);
 
 		CORE_ASSERT(m_Window, "Could not create window");
 
 		glfwMakeContextCurrent(m_Window);
-		gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-		glfwSwapInterval(1);
+		gl_utils::load_opengl((GLADloadproc)glfwGetProcAddress);
+		glfwSwapInterval(m_Headless ? 0 : 1);
 
 		if (info.icon.has_value())
 		{
@@ -190,15 +215,91 @@ namespace Atlas {
 			});
 	}
 
-	void Window::destroy() { glfwDestroyWindow(m_Window); }
+#ifdef ATLAS_HEADLESS_EGL
+	void Window::init_headless()
+	{
+		CORE_TRACE("Creating headless context ({0}, {1})", m_Width, m_Height);
+
+		// Mesa's surfaceless platform needs neither a display server nor a GPU, llvmpipe renders on the CPU
+		EGLDisplay display = EGL_NO_DISPLAY;
+		auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		CORE_ASSERT(display != EGL_NO_DISPLAY, "Could not get an EGL display");
+
+		EGLint major = 0, minor = 0;
+		EGLBoolean success = eglInitialize(display, &major, &minor);
+		CORE_ASSERT(success, "Could not initialize EGL: {:#x}", eglGetError());
+		CORE_TRACE("EGL {}.{} {}", major, minor, eglQueryString(display, EGL_VENDOR));
+
+		success = eglBindAPI(EGL_OPENGL_API);
+		CORE_ASSERT(success, "EGL does not support desktop OpenGL");
+
+		// rendering goes to textures only, a config is just needed by implementations without EGL_KHR_no_config_context
+		const EGLint configAttributes[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+
+		EGLConfig config = nullptr;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) config = nullptr;
+
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 5,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+			EGL_NONE
+		};
+
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		CORE_ASSERT(context != EGL_NO_CONTEXT, "Could not create a GL 4.5 core context through EGL: {:#x}", eglGetError());
+
+		success = eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+		CORE_ASSERT(success, "Could not make the surfaceless context current: {:#x}", eglGetError());
+
+		m_EGLDisplay = display;
+		m_EGLContext = context;
+
+		gl_utils::load_opengl((GLADloadproc)eglGetProcAddress);
+	}
+
+	void Window::destroy_headless()
+	{
+		eglMakeCurrent(m_EGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_EGLDisplay, m_EGLContext);
+		eglTerminate(m_EGLDisplay);
+
+		m_EGLContext = nullptr;
+		m_EGLDisplay = nullptr;
+	}
+#else
+	void Window::init_headless() {}
+	void Window::destroy_headless() {}
+#endif
+
+	void Window::destroy() {
+		if (m_EGLContext) destroy_headless();
+		if (m_Window) glfwDestroyWindow(m_Window);
+	}
 
 	void Window::on_update() {
 		ATL_EVENT();
+		if (m_EGLContext) return;
+
 		glfwPollEvents();
-		glfwSwapBuffers(m_Window);
+		if (!m_Headless) glfwSwapBuffers(m_Window);
+	}
+
+	void Window::request_close()
+	{
+		m_CloseRequested = true;
 	}
 
 	std::pair<float, float> Window::get_mouse_pos() const {
+		if (!m_Window) return { 0.0f, 0.0f };
+
 		double mouseX, mouseY;
 		glfwGetCursorPos(m_Window, &mouseX, &mouseY);
 		return { (float)mouseX, (float)mouseY };
@@ -206,6 +307,8 @@ namespace Atlas {
 
 	std::pair<float, float> Window::get_window_pos() const
 	{
+		if (!m_Window) return { 0.0f, 0.0f };
+
 		int posX, posY;
 		glfwGetWindowPos(m_Window, &posX, &posY);
 		return { (float)posX, (float)posY };
@@ -213,17 +316,21 @@ namespace Atlas {
 
 	double Window::get_time()
 	{
+		if (m_Headless) return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
 		return glfwGetTime();
 	}
 
-	bool Window::should_close() const { return glfwWindowShouldClose(m_Window); }
+	bool Window::should_close() const {
+		if (m_CloseRequested) return true;
+		return m_Window && glfwWindowShouldClose(m_Window);
+	}
 
 	void Window::set_event_callback(const EventCallbackFn &callback) {
 		m_EventCallBackFn = callback;
 	}
 
 	void Window::capture_mouse(bool enabled) {
-		if (enabled == m_CaptureMouse) return;
+		if (enabled == m_CaptureMouse || !m_Window) return;
 
 		if (enabled) {
 			glfwSetInputMode(m_Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);